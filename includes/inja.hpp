@@ -476,6 +476,8 @@ class DataNode : public ExpressionNode {
 public:
   const std::string name;
   const json::json_pointer ptr;
+  const std::string head;        // First segment of the name, e.g. "page" for "page.title"
+  const json::json_pointer tail; // Pointer to the rest of the name below the head
 
   static std::string convert_dot_to_ptr(std::string_view ptr_name) {
     std::string result;
@@ -488,7 +490,18 @@ public:
     return result;
   }
 
-  explicit DataNode(std::string_view ptr_name, size_t pos): ExpressionNode(pos), name(ptr_name), ptr(json::json_pointer(convert_dot_to_ptr(ptr_name))) {}
+  static std::string_view split_head(std::string_view ptr_name) {
+    return string_view::split(ptr_name, '.').first;
+  }
+
+  static json::json_pointer convert_tail_to_ptr(std::string_view ptr_name) {
+    const std::string_view rest = string_view::split(ptr_name, '.').second;
+    return rest.empty() ? json::json_pointer() : json::json_pointer(convert_dot_to_ptr(rest));
+  }
+
+  explicit DataNode(std::string_view ptr_name, size_t pos)
+      : ExpressionNode(pos), name(ptr_name), ptr(json::json_pointer(convert_dot_to_ptr(ptr_name))), head(split_head(ptr_name)),
+        tail(convert_tail_to_ptr(ptr_name)) {}
 
   void accept(NodeVisitor& v) const {
     v.visit(*this);
@@ -2151,6 +2164,14 @@ inline std::string htmlescape(const std::string& data) {
   return buffer;
 }
 
+/*!
+ * \brief Read-only values bound to top-level names, looked up before the main render data.
+ *
+ * Lets a caller layer small per-render data over a large shared json without copying either.
+ * A name that is bound but misses the requested path falls through to the main data.
+ */
+using DataLayer = std::vector<std::pair<std::string, const json*>>;
+
 /*!
  * \brief Class for rendering a Template with data.
  */
@@ -2167,17 +2188,79 @@ class Renderer : public NodeVisitor {
   std::vector<const BlockStatementNode*> block_statement_stack;
 
   const json* data_input;
+  const DataLayer* data_layer {nullptr};
   std::ostream* output_stream;
 
   json additional_data;
   json* current_loop_data = &additional_data["loop"];
+  // loop variables point into the iterated container instead of being copied into additional_data
+  DataLayer loop_bindings;
+
+  // an evaluated value, and whether it lives in additional_data, which later statements may overwrite
+  struct EvalResult {
+    const json* value;
+    bool local;
+
+    EvalResult(const json* value, bool local = false): value(value), local(local) {}
+
+    operator const json*() const {
+      return value;
+    }
+    const json* operator->() const {
+      return value;
+    }
+  };
 
   std::vector<std::shared_ptr<json>> data_tmp_stack;
-  std::stack<const json*> data_eval_stack;
+  std::stack<EvalResult> data_eval_stack;
+  // whether any of the values last taken by get_arguments lives in additional_data
+  bool arguments_local {false};
   std::stack<const DataNode*> not_found_stack;
 
   bool break_rendering {false};
 
+  const json* find_in_bindings(const std::string& head, const json::json_pointer& tail, bool& local) const {
+    // innermost loop first
+    for (auto it = loop_bindings.rbegin(); it != loop_bindings.rend(); ++it) {
+      if (it->first == head) {
+        // a loop variable that was assigned to has been moved into additional_data
+        const auto assigned = additional_data.find(head);
+        local = assigned != additional_data.end() && &*assigned == it->second;
+        return it->second->contains(tail) ? &(*it->second)[tail] : nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // ends the innermost loop binding; a loop variable that was assigned to is removed
+  // from additional_data with it, unless an enclosing loop of the same name still uses it
+  void pop_loop_binding() {
+    const auto [name, value] = loop_bindings.back();
+    loop_bindings.pop_back();
+    const auto assigned = additional_data.find(name);
+    if (assigned == additional_data.end() || &*assigned != value) {
+      return;
+    }
+    for (const auto& outer : loop_bindings) {
+      if (outer.second == value) {
+        return;
+      }
+    }
+    additional_data.erase(assigned);
+  }
+
+  const json* find_in_layer(const std::string& head, const json::json_pointer& tail) const {
+    if (!data_layer) {
+      return nullptr;
+    }
+    for (const auto& [key, value] : *data_layer) {
+      if (key == head && value->contains(tail)) {
+        return &(*value)[tail];
+      }
+    }
+    return nullptr;
+  }
+
   static bool truthy(const json* data) {
     if (data->is_boolean()) {
       return data->get<bool>();
@@ -2189,24 +2272,28 @@ class Renderer : public NodeVisitor {
     return !data->empty();
   }
 
-  void print_data(const std::shared_ptr<json>& value) {
-    if (value->is_string()) {
+  void print_data(const json& value) {
+    if (value.is_string()) {
+      const auto& str = value.get_ref<const json::string_t&>();
       if (config.html_autoescape) {
-        *output_stream << htmlescape(value->get_ref<const json::string_t&>());
+        *output_stream << htmlescape(str);
       } else {
-        *output_stream << value->get_ref<const json::string_t&>();
+        output_stream->write(str.data(), static_cast<std::streamsize>(str.size()));
       }
-    } else if (value->is_number_unsigned()) {
-      *output_stream << value->get<const json::number_unsigned_t>();
-    } else if (value->is_number_integer()) {
-      *output_stream << value->get<const json::number_integer_t>();
-    } else if (value->is_null()) {
+    } else if (value.is_number_unsigned()) {
+      *output_stream << value.get<const json::number_unsigned_t>();
+    } else if (value.is_number_integer()) {
+      *output_stream << value.get<const json::number_integer_t>();
+    } else if (value.is_null()) {
     } else {
-      *output_stream << value->dump();
+      *output_stream << value.dump();
     }
   }
 
-  const std::shared_ptr<json> eval_expression_list(const ExpressionListNode& expression_list) {
+  // The result is borrowed: it points into the render data, the template or
+  // data_tmp_stack, all of which outlive the render, or into additional_data,
+  // which later statements may overwrite; the latter are marked local.
+  EvalResult eval_expression_list(const ExpressionListNode& expression_list) {
     if (!expression_list.root) {
       throw_renderer_error("empty expression", expression_list);
     }
@@ -2232,7 +2319,7 @@ class Renderer : public NodeVisitor {
 
       throw_renderer_error("variable '" + static_cast<std::string>(node->name) + "' not found", *node);
     }
-    return std::make_shared<json>(*result);
+    return result;
   }
 
   void throw_renderer_error(const std::string& message, const AstNode& node) {
@@ -2240,8 +2327,8 @@ class Renderer : public NodeVisitor {
     INJA_THROW(RenderError(message, loc));
   }
 
-  void make_result(const json&& result) {
-    auto result_ptr = std::make_shared<json>(result);
+  void make_result(json&& result) {
+    auto result_ptr = std::make_shared<json>(std::move(result));
     data_tmp_stack.push_back(result_ptr);
     data_eval_stack.push(result_ptr.get());
   }
@@ -2260,8 +2347,10 @@ class Renderer : public NodeVisitor {
     }
 
     std::array<const json*, N> result;
+    arguments_local = false;
     for (size_t i = 0; i < N; i += 1) {
       result[N - i - 1] = data_eval_stack.top();
+      arguments_local = arguments_local || data_eval_stack.top().local;
       data_eval_stack.pop();
 
       if (!result[N - i - 1]) {
@@ -2324,8 +2413,13 @@ class Renderer : public NodeVisitor {
   }
 
   void visit(const DataNode& node) {
-    if (additional_data.contains(node.ptr)) {
-      data_eval_stack.push(&(additional_data[node.ptr]));
+    bool local = false;
+    if (const json* bound = find_in_bindings(node.head, node.tail, local)) {
+      data_eval_stack.push({bound, local});
+    } else if (additional_data.contains(node.ptr)) {
+      data_eval_stack.push({&(additional_data[node.ptr]), true});
+    } else if (const json* layered = find_in_layer(node.head, node.tail)) {
+      data_eval_stack.push(layered);
     } else if (data_input->contains(node.ptr)) {
       data_eval_stack.push(&(*data_input)[node.ptr]);
     } else {
@@ -2439,14 +2533,14 @@ class Renderer : public NodeVisitor {
       const auto id_node = not_found_stack.top();
       not_found_stack.pop();
       data_eval_stack.pop();
-      data_eval_stack.push(&container->at(id_node->name));
+      data_eval_stack.push({&container->at(id_node->name), arguments_local});
     } break;
     case Op::At: {
       const auto args = get_arguments<2>(node);
       if (args[0]->is_object()) {
-        data_eval_stack.push(&args[0]->at(args[1]->get<std::string>()));
+        data_eval_stack.push({&args[0]->at(args[1]->get<std::string>()), arguments_local});
       } else {
-        data_eval_stack.push(&args[0]->at(args[1]->get<int>()));
+        data_eval_stack.push({&args[0]->at(args[1]->get<int>()), arguments_local});
       }
     } break;
     case Op::Capitalize: {
@@ -2457,7 +2551,12 @@ class Renderer : public NodeVisitor {
     } break;
     case Op::Default: {
       const auto test_arg = get_arguments<1, 0, false>(node)[0];
-      data_eval_stack.push(test_arg ? test_arg : get_arguments<1, 1>(node)[0]);
+      if (test_arg) {
+        data_eval_stack.push({test_arg, arguments_local});
+      } else {
+        const auto fallback = get_arguments<1, 1>(node)[0];
+        data_eval_stack.push({fallback, arguments_local});
+      }
     } break;
     case Op::DivisibleBy: {
       const auto args = get_arguments<2>(node);
@@ -2469,7 +2568,8 @@ class Renderer : public NodeVisitor {
     } break;
     case Op::Exists: {
       auto&& name = get_arguments<1>(node)[0]->get_ref<const json::string_t&>();
-      make_result(data_input->contains(json::json_pointer(DataNode::convert_dot_to_ptr(name))));
+      make_result(find_in_layer(std::string(DataNode::split_head(name)), DataNode::convert_tail_to_ptr(name)) ||
+                  data_input->contains(json::json_pointer(DataNode::convert_dot_to_ptr(name))));
     } break;
     case Op::ExistsInObject: {
       const auto args = get_arguments<2>(node);
@@ -2478,7 +2578,7 @@ class Renderer : public NodeVisitor {
     } break;
     case Op::First: {
       const auto result = &get_arguments<1>(node)[0]->front();
-      data_eval_stack.push(result);
+      data_eval_stack.push({result, arguments_local});
     } break;
     case Op::Float: {
       make_result(std::stod(get_arguments<1>(node)[0]->get_ref<const json::string_t&>()));
@@ -2488,7 +2588,7 @@ class Renderer : public NodeVisitor {
     } break;
     case Op::Last: {
       const auto result = &get_arguments<1>(node)[0]->back();
-      data_eval_stack.push(result);
+      data_eval_stack.push({result, arguments_local});
     } break;
     case Op::Length: {
       const auto val = get_arguments<1>(node)[0];
@@ -2506,12 +2606,12 @@ class Renderer : public NodeVisitor {
     case Op::Max: {
       const auto args = get_arguments<1>(node);
       const auto result = std::max_element(args[0]->begin(), args[0]->end());
-      data_eval_stack.push(&(*result));
+      data_eval_stack.push({&(*result), arguments_local});
     } break;
     case Op::Min: {
       const auto args = get_arguments<1>(node);
       const auto result = std::min_element(args[0]->begin(), args[0]->end());
-      data_eval_stack.push(&(*result));
+      data_eval_stack.push({&(*result), arguments_local});
     } break;
     case Op::Odd: {
       make_result(get_arguments<1>(node)[0]->get<const json::number_integer_t>() % 2 != 0);
@@ -2618,7 +2718,7 @@ class Renderer : public NodeVisitor {
   }
 
   void visit(const ExpressionListNode& node) {
-    print_data(eval_expression_list(node));
+    print_data(*eval_expression_list(node));
   }
 
   void visit(const StatementNode&) {}
@@ -2626,11 +2726,19 @@ class Renderer : public NodeVisitor {
   void visit(const ForStatementNode&) {}
 
   void visit(const ForArrayStatementNode& node) {
-    const auto result = eval_expression_list(node.condition);
+    const EvalResult evaluated = eval_expression_list(node.condition);
+    const json* result = evaluated;
     if (!result->is_array()) {
       throw_renderer_error("object must be an array", node);
     }
 
+    // the loop body may overwrite additional_data, so only arrays living there are copied
+    json owned;
+    if (evaluated.local) {
+      owned = *result;
+      result = &owned;
+    }
+
     if (!current_loop_data->empty()) {
       auto tmp = *current_loop_data; // Because of clang-3
       (*current_loop_data)["parent"] = std::move(tmp);
@@ -2639,8 +2747,10 @@ class Renderer : public NodeVisitor {
     size_t index = 0;
     (*current_loop_data)["is_first"] = true;
     (*current_loop_data)["is_last"] = (result->size() <= 1);
+    const size_t binding = loop_bindings.size();
+    loop_bindings.emplace_back(static_cast<std::string>(node.value), nullptr);
     for (auto it = result->begin(); it != result->end(); ++it) {
-      additional_data[static_cast<std::string>(node.value)] = *it;
+      loop_bindings[binding].second = &*it;
 
       (*current_loop_data)["index"] = index;
       (*current_loop_data)["index1"] = index + 1;
@@ -2655,7 +2765,7 @@ class Renderer : public NodeVisitor {
       ++index;
     }
 
-    additional_data[static_cast<std::string>(node.value)].clear();
+    pop_loop_binding();
     if (!(*current_loop_data)["parent"].empty()) {
       const auto tmp = (*current_loop_data)["parent"];
       *current_loop_data = std::move(tmp);
@@ -2665,11 +2775,18 @@ class Renderer : public NodeVisitor {
   }
 
   void visit(const ForObjectStatementNode& node) {
-    const auto result = eval_expression_list(node.condition);
+    const EvalResult evaluated = eval_expression_list(node.condition);
+    const json* result = evaluated;
     if (!result->is_object()) {
       throw_renderer_error("object must be an object", node);
     }
 
+    json owned;
+    if (evaluated.local) {
+      owned = *result;
+      result = &owned;
+    }
+
     if (!current_loop_data->empty()) {
       (*current_loop_data)["parent"] = std::move(*current_loop_data);
     }
@@ -2677,9 +2794,11 @@ class Renderer : public NodeVisitor {
     size_t index = 0;
     (*current_loop_data)["is_first"] = true;
     (*current_loop_data)["is_last"] = (result->size() <= 1);
+    const size_t binding = loop_bindings.size();
+    loop_bindings.emplace_back(static_cast<std::string>(node.value), nullptr);
     for (auto it = result->begin(); it != result->end(); ++it) {
       additional_data[static_cast<std::string>(node.key)] = it.key();
-      additional_data[static_cast<std::string>(node.value)] = it.value();
+      loop_bindings[binding].second = &it.value();
 
       (*current_loop_data)["index"] = index;
       (*current_loop_data)["index1"] = index + 1;
@@ -2695,7 +2814,7 @@ class Renderer : public NodeVisitor {
     }
 
     additional_data[static_cast<std::string>(node.key)].clear();
-    additional_data[static_cast<std::string>(node.value)].clear();
+    pop_loop_binding();
     if (!(*current_loop_data)["parent"].empty()) {
       *current_loop_data = std::move((*current_loop_data)["parent"]);
     } else {
@@ -2704,8 +2823,8 @@ class Renderer : public NodeVisitor {
   }
 
   void visit(const IfStatementNode& node) {
-    const auto result = eval_expression_list(node.condition);
-    if (truthy(result.get())) {
+    const json* result = eval_expression_list(node.condition);
+    if (truthy(result)) {
       node.true_statement.accept(*this);
     } else if (node.has_false_statement) {
       node.false_statement.accept(*this);
@@ -2716,7 +2835,8 @@ class Renderer : public NodeVisitor {
     auto sub_renderer = Renderer(config, template_storage, function_storage);
     const auto included_template_it = template_storage.find(node.file);
     if (included_template_it != template_storage.end()) {
-      sub_renderer.render_to(*output_stream, included_template_it->second, *data_input, &additional_data);
+      sub_renderer.loop_bindings = loop_bindings;
+      sub_renderer.render_to(*output_stream, included_template_it->second, *data_input, &additional_data, data_layer);
     } else if (config.throw_at_missing_includes) {
       throw_renderer_error("include '" + node.file + "' not found", node);
     }
@@ -2726,7 +2846,7 @@ class Renderer : public NodeVisitor {
     const auto included_template_it = template_storage.find(node.file);
     if (included_template_it != template_storage.end()) {
       const Template* parent_template = &included_template_it->second;
-      render_to(*output_stream, *parent_template, *data_input, &additional_data);
+      render_to(*output_stream, *parent_template, *data_input, &additional_data, data_layer);
       break_rendering = true;
     } else if (config.throw_at_missing_includes) {
       throw_renderer_error("extends '" + node.file + "' not found", node);
@@ -2751,17 +2871,32 @@ class Renderer : public NodeVisitor {
     std::string ptr = node.key;
     replace_substring(ptr, ".", "/");
     ptr = "/" + ptr;
-    additional_data[json::json_pointer(ptr)] = *eval_expression_list(node.expression);
+    const json* value = eval_expression_list(node.expression);
+
+    // assigning to a loop variable (or below it) replaces the binding with a copy that can be changed
+    const std::string head = node.key.substr(0, node.key.find('.'));
+    for (auto it = loop_bindings.rbegin(); it != loop_bindings.rend(); ++it) {
+      if (it->first == head) {
+        json& local = additional_data[head];
+        if (node.key != head) {
+          local = *it->second;
+        }
+        it->second = &local;
+        break;
+      }
+    }
+    additional_data[json::json_pointer(ptr)] = *value;
   }
 
 public:
   Renderer(const RenderConfig& config, const TemplateStorage& template_storage, const FunctionStorage& function_storage)
       : config(config), template_storage(template_storage), function_storage(function_storage) {}
 
-  void render_to(std::ostream& os, const Template& tmpl, const json& data, json* loop_data = nullptr) {
+  void render_to(std::ostream& os, const Template& tmpl, const json& data, json* loop_data = nullptr, const DataLayer* layer = nullptr) {
     output_stream = &os;
     current_template = &tmpl;
     data_input = &data;
+    data_layer = layer;
     if (loop_data) {
       additional_data = *loop_data;
       current_loop_data = &additional_data["loop"];
@@ -2890,6 +3025,13 @@ public:
     return os.str();
   }
 
+  /// Renders with the values in layer shadowing the matching top-level names in data
+  std::string render(const Template& tmpl, const json& data, const DataLayer& layer) {
+    std::stringstream os;
+    render_to(os, tmpl, data, layer);
+    return os.str();
+  }
+
   std::string render_file(const std::filesystem::path& filename, const json& data) {
     return render(parse_template(filename), data);
   }
@@ -2926,6 +3068,11 @@ public:
     return os;
   }
 
+  std::ostream& render_to(std::ostream& os, const Template& tmpl, const json& data, const DataLayer& layer) {
+    Renderer(render_config, template_storage, function_storage).render_to(os, tmpl, data, nullptr, &layer);
+    return os;
+  }
+
   std::ostream& render_to(std::ostream& os, const std::string_view input, const json& data) {
     return render_to(os, parse(input), data);
   }
@@ -2976,6 +3123,11 @@ public:
     });
   }
 
+  /// Templates pulled in through include or extends, keyed by the name their statement refers to
+  const TemplateStorage& get_template_storage() const {
+    return template_storage;
+  }
+
   /** Includes a template with a given name into the environment.
    * Then, a template can be rendered in another template using the
    * include "<name>" syntax.
@@ -0,0 +1,99 @@
+#include "build_session.hpp"
+#include "../utils/utils.hpp"
+
+std::string BuildSession::key(const std::filesystem::path& path) {
+    return std::filesystem::absolute(path).lexically_normal().string();
+}
+
+bool BuildSession::filter(std::set<std::filesystem::path>& paths) {
+    std::string content;
+    for (auto it = paths.begin(); it != paths.end();) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(*it, ec) || !utils::read_file(*it, content)) {
+            // removed, a directory, or unreadable: always worth a rebuild
+            ++it;
+            continue;
+        }
+
+        std::uint64_t file_hash = utils::hash(content);
+        std::string path_key = key(*it);
+
+        std::lock_guard<std::mutex> lock(session_mutex);
+        auto known = file_hashes.find(path_key);
+        if (known != file_hashes.end() && known->second == file_hash) {
+            it = paths.erase(it);
+            continue;
+        }
+        // only trusted once a build has used it
+        pending_hashes[path_key] = file_hash;
+        ++it;
+    }
+    return !paths.empty();
+}
+
+void BuildSession::addChanges(const std::set<std::filesystem::path>& paths, bool all) {
+    std::lock_guard<std::mutex> lock(session_mutex);
+    everything = everything || all;
+    for (const auto& path : paths) {
+        changed.insert(key(path));
+    }
+}
+
+bool BuildSession::isChanged(const std::filesystem::path& path) const {
+    std::string path_key = key(path);
+
+    std::lock_guard<std::mutex> lock(session_mutex);
+    return everything || changed.count(path_key) > 0;
+}
+
+std::shared_ptr<const BuildSession::Source> BuildSession::find(const std::filesystem::path& path) const {
+    std::string path_key = key(path);
+
+    std::lock_guard<std::mutex> lock(session_mutex);
+    auto it = sources.find(path_key);
+    return it != sources.end() ? it->second : nullptr;
+}
+
+void BuildSession::store(const std::filesystem::path& path, std::shared_ptr<const Source> source) {
+    std::string path_key = key(path);
+
+    std::lock_guard<std::mutex> lock(session_mutex);
+    sources[path_key] = std::move(source);
+}
+
+void BuildSession::remember(const std::filesystem::path& path, std::uint64_t file_hash) {
+    std::string path_key = key(path);
+
+    std::lock_guard<std::mutex> lock(session_mutex);
+    pending_hashes[path_key] = file_hash;
+}
+
+std::optional<Manifest> BuildSession::takeManifest() {
+    std::lock_guard<std::mutex> lock(session_mutex);
+    std::optional<Manifest> taken = std::move(manifest);
+    manifest.reset();
+    return taken;
+}
+
+void BuildSession::keepManifest(Manifest built) {
+    std::lock_guard<std::mutex> lock(session_mutex);
+    manifest = std::move(built);
+}
+
+void BuildSession::finish(const std::vector<std::filesystem::path>& seen) {
+    std::set<std::string> seen_keys;
+    for (const auto& path : seen) {
+        seen_keys.insert(key(path));
+    }
+
+    std::lock_guard<std::mutex> lock(session_mutex);
+    for (auto it = sources.begin(); it != sources.end();) {
+        it = seen_keys.count(it->first) ? std::next(it) : sources.erase(it);
+    }
+    for (auto& [path_key, file_hash] : pending_hashes) {
+        file_hashes[path_key] = file_hash;
+    }
+    pending_hashes.clear();
+    changed.clear();
+    everything = false;
+}
@@ -0,0 +1,62 @@
+#ifndef BUILD_SESSION_HPP_
+#define BUILD_SESSION_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "manifest.hpp"
+#include "page.hpp"
+#include "rendered_markdown.hpp"
+
+// What a long-running server remembers between builds: every content file in
+// parsed form, the content hash of every file it has read, and the manifest of
+// the last build whose output never reaches the disk. A rebuild only
+// re-reads the paths reported as changed; the rest is taken from here.
+// Safe to use from several threads.
+class BuildSession {
+public:
+    struct Source {
+        PageSource page;
+        RenderedMarkdown content;
+    };
+
+private:
+    mutable std::mutex session_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const Source>> sources;
+    std::unordered_map<std::string, std::uint64_t> file_hashes;     // as of the last finished build
+    std::unordered_map<std::string, std::uint64_t> pending_hashes;  // read since then
+    std::set<std::string> changed;
+    bool everything = true;     // nothing is known before the first build
+    std::optional<Manifest> manifest;
+
+    static std::string key(const std::filesystem::path& path);
+
+public:
+    // drops files whose content is what the last finished build read, so saves
+    // that only touch timestamps cause no rebuild; true if anything is left
+    bool filter(std::set<std::filesystem::path>& paths);
+    // changes accumulate until a build finishes, so a failed build is retried in full
+    void addChanges(const std::set<std::filesystem::path>& paths, bool all = false);
+    bool isChanged(const std::filesystem::path& path) const;
+
+    std::shared_ptr<const Source>   find(const std::filesystem::path& path) const;
+    void                            store(const std::filesystem::path& path, std::shared_ptr<const Source> source);
+    void                            remember(const std::filesystem::path& path, std::uint64_t file_hash);
+
+    // in-memory builds hand their manifest over here instead of saving it; taking it
+    // leaves nothing behind, so a build that stops halfway is followed by a full one
+    std::optional<Manifest>         takeManifest();
+    void                            keepManifest(Manifest built);
+
+    // forgets sources that were not part of this build, keeps the file hashes read
+    // for it and clears the change set
+    void finish(const std::vector<std::filesystem::path>& seen);
+};
+
+#endif
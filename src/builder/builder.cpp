@@ -7,79 +7,132 @@
 #include <string>
 #include <cctype>
 #include <set>
+#include <algorithm>
+#include <iterator>
 #include <unordered_set>
+#include <tuple>
 
 #include "../utils/utils.hpp"
 #include "builder.hpp"
+#include "manifest.hpp"
 #include "../directives/directive.hpp"
 
-namespace {
-    std::string slugify(const std::string& value)
-    {
-        std::string slug;
-        slug.reserve(value.size());
-
-        bool last_was_hyphen = false;
-        for (unsigned char c : value) {
-            if (std::isalnum(c)) {
-                slug.push_back(static_cast<char>(std::tolower(c)));
-                last_was_hyphen = false;
-            }
-            else if (std::isspace(c) || c == '-' || c == '_' || c == '/') {
-                if (!last_was_hyphen && !slug.empty()) {
-                    slug.push_back('-');
-                    last_was_hyphen = true;
-                }
-            }
-        }
-
-        while (!slug.empty() && slug.back() == '-') {
-            slug.pop_back();
-        }
-
-        if (slug.empty()) {
-            slug = "tag";
-        }
+Builder::Builder(Feeder& feeder, ThreadPool& pool, const std::string& live_reload_snippet, BuildSession* session) :
+    feeder(feeder),
+    pool(pool),
+    live_reload_snippet(live_reload_snippet),
+    markdown_cache(markdownCacheFactory(feeder.getConfig())),
+    session(session) {
+}
 
-        return slug;
+MarkdownCache Builder::markdownCacheFactory(Config& config) {
+    std::uintmax_t max_size_mb = MarkdownCache::DEFAULT_MAX_SIZE_MB;
+    if (config.getData().hasKey("site", "markdown_cache_mb")) {
+        max_size_mb = config.getData().get<std::uintmax_t>("site", "markdown_cache_mb");
     }
-}
 
-Builder::Builder(Feeder& feeder, const std::string& live_reload_snippet) :
-    feeder(feeder),
-    live_reload_snippet(live_reload_snippet) {
+    return MarkdownCache(
+        config.getStateDirectory() / "cache" / "markdown",
+        max_size_mb * 1024 * 1024,
+        MD_PARSER_FLAGS
+    );
 }
 
 Builder::~Builder() { }
 
 void Builder::build() {
-    unsigned int num_threads = std::thread::hardware_concurrency();
-    LOG_INFO("Building with: " << num_threads << " threads");
+    LOG_INFO("Building with: " << pool.size() << " threads");
 
+    Config& config = feeder.getConfig();
+    // site and theme config only; pages and directive data are added further down
+    std::string config_dump = config.getData().getJsonRef().dump();
+
+    Output& output = config.getOutput();
+    Manifest previous(config.getStateDirectory());
+    bool incremental = false;
+    if (output.inMemory()) {
+        // in-memory builds keep their manifest in the session, so it never vouches for
+        // files on disk; the store is served while building and is never cleared, a
+        // full build instead removes whatever it did not write
+        if (std::optional<Manifest> kept = session ? session->takeManifest() : std::nullopt) {
+            previous = std::move(*kept);
+            incremental = true;
+        }
+        else {
+            previous.setOutputs(output.getStored());
+        }
+    }
+    else {
+        incremental = previous.load();
+        previous.discard();
+        if (!incremental) {
+            output.clear();
+        }
+    }
+
+    Manifest manifest(config.getStateDirectory());
+    manifest.setConfigHash(utils::to_hex(utils::hash(live_reload_snippet, utils::hash(config_dump))));
+    previous_manifest = incremental ? &previous : nullptr;
+    // theme templates are tracked per page through their template hash
+    config_unchanged = incremental && previous.getConfigHash() == manifest.getConfigHash();
+
+    // pages whose templates read no site-wide data are rendered by the content threads
     std::vector<Page> processed_pages;
-    start_content_threads(num_threads, processed_pages);
+    run_content_tasks(processed_pages);
+    if (markdown_cache.enabled()) {
+        LOG_INFO("Markdown cache: " << markdown_cache.getHits() << " hits, " << markdown_cache.getMisses() << " misses");
+    }
 
-    Config& config = feeder.getConfig();
-    std::filesystem::path output_dir = config.getSiteDirectory() / "output";
-    utils::clear_directory(output_dir);
+    collect_pages(processed_pages, config);
+    sort_and_store_pages(processed_pages, config);
+    manifest.setSiteHash(hash_site_inputs(processed_pages, config, manifest.getConfigHash(), false));
+    manifest.setPagesHash(hash_site_inputs(processed_pages, config, manifest.getConfigHash(), true));
+    process_directives(config, manifest);
+    check_up_to_date(processed_pages, config, manifest);
 
-    collect_and_validate_pages(processed_pages, config);
-    sort_and_store_pages(config);
-    process_directives(config);
-    start_render_threads(num_threads, processed_pages, config);
+    run_render_tasks(processed_pages, config);
     copy_theme_assets(config);
     copy_assets(config);
+
+    std::set<std::string> written = output.getWritten();
+    if (incremental || output.inMemory()) {
+        remove_stale_outputs(config, previous, written);
+    }
+    manifest.setOutputs(std::move(written));
+    if (output.inMemory()) {
+        if (session) {
+            session->keepManifest(std::move(manifest));
+        }
+    }
+    else if (!manifest.save()) {
+        LOG_WARN("Failed to save build manifest; the next build will start clean");
+    }
+
+    markdown_cache.trim();
+    if (session) {
+        std::vector<std::filesystem::path> sources;
+        sources.reserve(feeder.size());
+        for (std::size_t i = 0; i < feeder.size(); ++i) {
+            sources.push_back(feeder.getPath(i));
+        }
+        session->finish(sources);
+    }
 }
 
 
-void Builder::process_directives(Config& config) {
+void Builder::process_directives(Config& config, Manifest& manifest) {
     Data& data = config.getData();
     data.set<bool>(false, "directives", "index");
     data.set<std::string>("off", "directives", "tags");
 
+    // directive pages are built from the config and the frontmatter of every page,
+    // which is exactly what the site hash covers, plus the bodies if their templates
+    // print them
+    bool site_unchanged = config_unchanged && previous_manifest->getSiteHash() == manifest.getSiteHash();
     std::vector<nlohmann::json> directives = config.get_directives();
 
-    for (const nlohmann::json& directive : directives) {
+    for (std::size_t position = 0; position < directives.size(); ++position) {
+        const nlohmann::json& directive = directives[position];
         if (!directive.contains("name") || !directive["name"].is_string()) {
             LOG_WARN("Directive missing 'name' field or it is not a string.");
             continue;
@@ -101,8 +154,28 @@ void Builder::process_directives(Config& config) {
                 reset_tags = true;
             }
 
+            std::string key = std::to_string(position) + ":" + directive_name;
+            auto directive_hash = [this, &config, &manifest, &directive](const std::vector<std::string>& templates) {
+                std::uint64_t hash = utils::hash(directive.dump(), utils::hash(manifest.getSiteHash()));
+                if (reads_page_bodies(config, templates)) {
+                    hash = utils::hash(manifest.getPagesHash(), hash);
+                }
+                return utils::to_hex(hash);
+            };
+            Manifest::Entry entry;
+
+            const Manifest::Entry* previous_entry = site_unchanged ? previous_manifest->findDirective(key) : nullptr;
+            bool up_to_date = previous_entry && previous_entry->hash == directive_hash(previous_entry->templates)
+                && matches_templates(config, *previous_entry)
+                && std::all_of(previous_entry->outputs.begin(), previous_entry->outputs.end(), [&config](const std::string& output) {
+                    return config.getOutput().exists(config.getOutputDirectory() / output);
+                });
+            std::set<std::string> written_before = config.getOutput().getWritten();
+            // whatever the directive asks for from here on is what its pages are rendered from
+            config.takeRequestedTemplates();
+
             try {
-                d->init(config, directive);
+                d->init(config, pool, directive, !up_to_date);
             }
             catch (...) {
                 if (reset_index) {
@@ -113,39 +186,77 @@ void Builder::process_directives(Config& config) {
                 }
                 throw;
             }
+
+            if (up_to_date) {
+                for (const auto& output : previous_entry->outputs) {
+                    config.getOutput().record(config.getOutputDirectory() / output);
+                }
+                entry.hash = previous_entry->hash;
+                entry.templates = previous_entry->templates;
+                entry.template_hash = previous_entry->template_hash;
+                entry.outputs = previous_entry->outputs;
+                LOG_INFO("Directive '" << directive_name << "' is up to date");
+            }
+            else {
+                std::set<std::string> requested = config.takeRequestedTemplates();
+                entry.templates.assign(requested.begin(), requested.end());
+                entry.template_hash = hash_templates(config, entry.templates);
+                entry.hash = directive_hash(entry.templates);
+
+                std::set<std::string> written = config.getOutput().getWritten();
+                std::set_difference(
+                    written.begin(), written.end(),
+                    written_before.begin(), written_before.end(),
+                    std::back_inserter(entry.outputs)
+                );
+            }
+            manifest.setDirective(key, std::move(entry));
         }
     }
 }
 
-void Builder::start_content_threads(unsigned int num_threads, std::vector<Page>& processed_pages) {
-    std::vector<std::thread> threads;
+void Builder::run_content_tasks(std::vector<Page>& processed_pages) {
+    TaskGroup group(pool);
     std::mutex processed_pages_mutex;
 
-    for (unsigned int i = 0; i < num_threads; ++i) {
-        threads.emplace_back([this, &processed_pages, &processed_pages_mutex] {
-            content_worker_thread(processed_pages, processed_pages_mutex);
+    // one task per worker, each pulling pages from the feeder until it runs dry
+    for (unsigned int i = 0; i < pool.size(); ++i) {
+        group.submit([this, &processed_pages, &processed_pages_mutex] {
+            content_worker(processed_pages, processed_pages_mutex);
         });
     }
-    for (auto& thread : threads) {
-        if (thread.joinable()) thread.join();
-    }
+    group.wait();
 }
 
-void Builder::content_worker_thread(std::vector<Page>& processed_pages, std::mutex& processed_pages_mutex) {
+void Builder::content_worker(std::vector<Page>& processed_pages, std::mutex& processed_pages_mutex) {
     Config& config = feeder.getConfig();
-    std::optional<std::pair<std::int32_t, std::filesystem::path>> page_path_opt = feeder.getNext();
-
-    while (page_path_opt.has_value()) {
-        auto [index, page_path] = page_path_opt.value();
+    std::string source_buffer;
+    for (auto [first, last] = feeder.claim(); first != last; std::tie(first, last) = feeder.claim()) {
+        const std::size_t index = first + 1;
+        const std::filesystem::path& page_path = feeder.getPath(first);
         LOG_INFO("Processing content (index: " << index << "): " << page_path);
 
         try {
-            auto [markdown, frontmatter] = read_and_extract(page_path);
-            Data page_data((std::string(frontmatter)));
-            std::size_t word_count = count_words(markdown);
-            std::string html = generate_html(markdown);
-            page_data.set<std::string>(html, "content");
-            page_data.set<std::size_t>(word_count, "word_count");
+            // a server session already holds every file it was not told has changed
+            std::shared_ptr<const BuildSession::Source> known = session ? session->find(page_path) : nullptr;
+            std::shared_ptr<BuildSession::Source> parsed;
+            if (!known || session->isChanged(page_path)) {
+                parsed = parse_source(page_path, source_buffer, known);
+            }
+
+            Data page_data;
+            PageSource source;
+            if (parsed && !session) {
+                page_data = Data(parsed->page.frontmatter.takeJson());
+                set_content(page_data, std::move(parsed->content));
+                source = std::move(parsed->page);
+            }
+            else {
+                const BuildSession::Source& current = parsed ? *parsed : *known;
+                page_data = Data(current.page.frontmatter.toJson(config.getFrontmatterKeys()));
+                set_content(page_data, current.content);
+                source = current.page;
+            }
 
             std::string output_path = utils::getOutputPath(
                 config.getSiteDirectory() / "content",
@@ -161,168 +272,370 @@ void Builder::content_worker_thread(std::vector<Page>& processed_pages, std::mut
             );
             page_data.set<std::string>(output_url, "url");
 
+            Page page(std::move(page_data), std::move(source));
+            prepare_page(page, config);
+            render_if_independent(page, config);
+
             {
                 std::lock_guard<std::mutex> lock(processed_pages_mutex);
-                processed_pages.push_back(Page(page_data));
+                processed_pages.push_back(std::move(page));
             }
             LOG_INFO("Finished processing content (index: " << index << ")");
         } catch (const std::exception& e) {
             LOG_ERROR("Error processing content: "  << page_path);
             LOG_ERROR("Error message: "             << e.what());
         }
-        page_path_opt = feeder.getNext();
     }
 }
 
-void Builder::start_render_threads(unsigned int num_threads, std::vector<Page>& processed_pages, Config& config) {
-    std::vector<std::thread> threads;
-    std::atomic<size_t> page_index{ 0 };
-
-    for (unsigned int i = 0; i < num_threads; ++i) {
-        std::string snippet_copy = live_reload_snippet;
-        threads.emplace_back([&processed_pages, &config, &page_index, snippet_copy] {
-            while (true) {
-                size_t idx = page_index.fetch_add(1);
-                if (idx >= processed_pages.size()) break;
-                processed_pages[idx].render(config, snippet_copy);
-            }
-            });
+std::shared_ptr<BuildSession::Source> Builder::parse_source(
+    const std::filesystem::path& page_path,
+    std::string& buffer,
+    const std::shared_ptr<const BuildSession::Source>& known
+)
+{
+    auto [markdown, frontmatter] = read_and_extract(page_path, buffer);
+
+    PageSource source;
+    source.path = page_path;
+    source.frontmatter_hash = utils::hash(frontmatter);
+    source.hash = utils::hash(markdown, source.frontmatter_hash);
+    if (session) {
+        session->remember(page_path, utils::hash(buffer));
+        // reported as changed, but saved with the same content
+        if (known && known->page.hash == source.hash) {
+            return nullptr;
+        }
     }
-    for (auto& thread : threads) {
-        if (thread.joinable()) thread.join();
+
+    auto parsed = std::make_shared<BuildSession::Source>();
+    parsed->page = std::move(source);
+    // a session keeps the source for later builds, whose templates may name more keys
+    parsed->page.frontmatter = Frontmatter(frontmatter, feeder.getConfig().getFrontmatterKeys(), session != nullptr);
+
+    std::optional<MarkdownCache::Entry> converted = markdown_cache.find(markdown);
+    if (!converted.has_value()) {
+        converted.emplace(markdown, MD_PARSER_FLAGS);
+        markdown_cache.store(markdown, converted.value());
     }
-}
+    parsed->content = std::move(converted.value());
 
-std::pair<std::string, std::string> Builder::read_and_extract(const std::filesystem::path& page_path) {
-    std::ifstream markdown_file(page_path);
-    if (!markdown_file.is_open()) {
-        throw std::runtime_error("Failed to open markdown file: " + page_path.string());
+    if (session) {
+        session->store(page_path, parsed);
     }
+    return parsed;
+}
+
+void Builder::run_render_tasks(std::vector<Page>& processed_pages, Config& config) {
+    utils::parallel_for(pool, processed_pages.size(), [this, &processed_pages, &config](std::size_t idx) {
+        if (!processed_pages[idx].isRendered()) {
+            render_page(processed_pages[idx], config, live_reload_snippet);
+        }
+    });
+}
 
-    std::stringstream file_content_stream;
-    std::string line;
-    while (std::getline(markdown_file, line)) {
-        file_content_stream << line << '\n';
+std::pair<std::string_view, std::string_view> Builder::read_and_extract(const std::filesystem::path& page_path, std::string& buffer) {
+    if (!utils::read_file(page_path, buffer)) {
+        throw std::runtime_error("Failed to open markdown file: " + page_path.string());
     }
-    std::string file_content = file_content_stream.str();
 
-    auto extracted = utils::extract(file_content, utils::MARKDOWN | utils::FRONTMATTER);
+    auto extracted = utils::extract(buffer, utils::MARKDOWN | utils::FRONTMATTER);
     if (!extracted.first.has_value() || !extracted.second.has_value()) {
         throw std::runtime_error("Failed to extract markdown and frontmatter from file: " + page_path.string());
     }
     return {extracted.first.value(), extracted.second.value()};
 }
 
-std::string Builder::generate_html(const std::string_view& markdown) {
-    std::stringstream html_stream;
-    md_html(markdown.data(), markdown.length(), utils::handle_md, &html_stream, 0, 0);
-    return html_stream.str();
+void Builder::set_content(Data& page_data, RenderedMarkdown content) {
+    page_data.set<std::size_t>(content.word_count, "word_count");
+    page_data.set<std::string>(std::move(content.html), "content");
+
+    // the frontmatter may provide its own
+    if (!page_data.hasKey("reading_time")) {
+        page_data.set<std::size_t>(content.readingTime(), "reading_time");
+    }
+    if (!page_data.hasKey("excerpt")) {
+        page_data.set<std::string>(std::move(content.excerpt), "excerpt");
+    }
+    if (!page_data.hasKey("toc")) {
+        nlohmann::json toc = nlohmann::json::array();
+        for (auto& heading : content.toc) {
+            toc.push_back({
+                { "level", heading.level },
+                { "id", std::move(heading.id) },
+                { "title", std::move(heading.title) }
+            });
+        }
+        page_data.set<nlohmann::json>(std::move(toc), "toc");
+    }
 }
 
-void Builder::collect_and_validate_pages(std::vector<Page>& processed_pages, Config& config) {
-    std::unordered_map<std::string, nlohmann::json> all_tags;
+void Builder::prepare_page(Page& page, Config& config) {
+    page.validate(config);
+
+    Data& page_data = page.getPageData();
+    std::vector<std::string> normalized_tags;
+    std::unordered_set<std::string> seen_tags;
+
+    const Frontmatter& frontmatter = page.getSource().frontmatter;
+
+    if (frontmatter.ignored_tags > 0) {
+        LOG_WARN("Ignoring " << frontmatter.ignored_tags << " non-string tag value(s) in page frontmatter tags");
+    }
+    if (frontmatter.tags_form == Frontmatter::TagsForm::Other) {
+        LOG_WARN("Unsupported tags frontmatter value detected; expected an array or string");
+    }
+
+    normalized_tags.reserve(frontmatter.tags.size());
+    for (const auto& tag : frontmatter.tags) {
+        if (!tag.empty() && seen_tags.insert(tag).second) {
+            normalized_tags.push_back(tag);
+        }
+    }
+
+    std::vector<TagIndex::Id> tag_ids;
+    tag_ids.reserve(normalized_tags.size());
+    for (const auto& tag : normalized_tags) {
+        tag_ids.push_back(config.getTagIndex().intern(tag));
+    }
+    page.setTagIds(std::move(tag_ids));
+
+    if (normalized_tags.empty()) {
+        page_data.set<nlohmann::json>(nlohmann::json::array(), "tags");
+    }
+    else {
+        page_data.set<std::vector<std::string>>(normalized_tags, "tags");
+    }
+}
 
+void Builder::collect_pages(std::vector<Page>& processed_pages, Config& config) {
     for (auto& page : processed_pages) {
-        page.validate(config);
-
-        Data& page_data = page.getPageData();
-        std::vector<std::string> normalized_tags;
-        std::unordered_set<std::string> seen_tags;
-
-        if (page_data.hasKey("tags")) {
-            nlohmann::json raw_tags = page_data.get<nlohmann::json>("tags");
-
-            if (raw_tags.is_array()) {
-                normalized_tags.reserve(raw_tags.size());
-                for (const auto& tag_value : raw_tags) {
-                    if (!tag_value.is_string()) {
-                        LOG_WARN("Ignoring non-string tag value in page frontmatter tags");
-                        continue;
-                    }
-
-                    std::string tag = tag_value.get<std::string>();
-                    if (tag.empty()) {
-                        continue;
-                    }
-
-                    if (seen_tags.insert(tag).second) {
-                        std::string slug = slugify(tag);
-                        all_tags.try_emplace(slug, nlohmann::json::object());
-                        nlohmann::json& tag_entry = all_tags[slug];
-                        if (!tag_entry.contains("name")) {
-                            tag_entry["name"] = tag;
-                            tag_entry["slug"] = slug;
-                            tag_entry["count"] = 0;
-                        }
-                        tag_entry["count"] = tag_entry["count"].get<std::size_t>() + 1;
-                        normalized_tags.push_back(tag);
-                    }
-                }
+        config.getData().add(page.getPageData(), "pages");
+    }
+}
+
+void Builder::sort_and_store_pages(std::vector<Page>& processed_pages, Config& config) {
+    PageStore& page_store = config.getPageStore();
+    page_store.reserve(processed_pages.size());
+    for (const auto& page : processed_pages) {
+        page_store.add(page.getRecord());
+    }
+    std::vector<std::size_t> order = page_store.sort();
+
+    // posting lists refer to positions in site.pages, so they are filled in its order
+    TagIndex& tag_index = config.getTagIndex();
+    nlohmann::json pages = nlohmann::json::array();
+    for (std::size_t position = 0; position < order.size(); ++position) {
+        Page& page = processed_pages[order[position]];
+        const nlohmann::json& page_data = page.getPageData().getJsonRef();
+        tag_index.add(position, page.getRecord().tag_ids, page_data["tags"]);
+        pages.push_back(page_data);
+    }
+    tag_index.finish();
+
+    // page.all_tags is bound once for every page; a theme that reads it from a listed
+    // page, such as p.all_tags in a loop over site.pages, gets a copy in each entry
+    if (config.templatesReadField("all_tags", { "page.all_tags", "site.all_tags" })) {
+        for (auto& listed : pages) {
+            listed["all_tags"] = tag_index.summary();
+        }
+    }
+
+    config.getData().set<nlohmann::json>(std::move(pages), "site", "pages");
+    page_store.attach(config.getData().getJsonRef()["site"]["pages"]);
+    config.getData().set<nlohmann::json>(tag_index.summary(), "site", "all_tags");
+}
+
+std::string Builder::hash_site_inputs(const std::vector<Page>& processed_pages, Config& config, const std::string& config_hash, bool bodies) {
+    // every page can list every other page, so the inputs shared by all pages are
+    // the config and the frontmatter of each page; markdown bodies only matter to
+    // templates that print other pages' content
+    std::vector<std::pair<std::string, std::uint64_t>> sources;
+    sources.reserve(processed_pages.size());
+    for (const auto& page : processed_pages) {
+        sources.emplace_back(
+            page.getSource().path.lexically_relative(config.getSiteDirectory()).generic_string(),
+            bodies ? page.getSource().hash : page.getSource().frontmatter_hash
+        );
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::uint64_t site_hash = utils::hash(config_hash);
+    for (const auto& [source, hash] : sources) {
+        site_hash = utils::hash(source, site_hash);
+        site_hash = utils::hash(utils::to_hex(hash), site_hash);
+    }
+    return utils::to_hex(site_hash);
+}
+
+std::string Builder::hash_templates(Config& config, const std::vector<std::string>& template_names) {
+    std::uint64_t combined = utils::HASH_SEED;
+    try {
+        for (const auto& template_name : template_names) {
+            combined = utils::hash(template_name, combined);
+            combined = utils::hash(config.getTemplateHash(template_name), combined);
+        }
+    }
+    catch (const std::exception&) {
+        // a template that does not load never counts as unchanged
+        return {};
+    }
+    return utils::to_hex(combined);
+}
+
+bool Builder::matches_templates(Config& config, const Manifest::Entry& previous_entry) {
+    return !previous_entry.template_hash.empty()
+        && previous_entry.template_hash == hash_templates(config, previous_entry.templates);
+}
+
+bool Builder::reads_site_aggregates(const TemplateDependencies& dependencies) {
+    if (dependencies.dynamic) {
+        return true;
+    }
+
+    for (const auto& variable : dependencies.variables) {
+        std::string head = variable.substr(0, variable.find('.'));
+        // whole objects, and anything outside site/page/theme such as the top level
+        // pages list or the directive flags, are only complete after all content is in
+        if (variable == "site" || variable == "page" || (head != "site" && head != "page" && head != "theme")) {
+            return true;
+        }
+    }
+
+    return dependencies.reads("site.pages")
+        || dependencies.reads("site.all_tags")
+        || dependencies.reads("site.tags")
+        || dependencies.reads("page.all_tags");
+}
+
+bool Builder::reads_page_bodies(Config& config, const std::vector<std::string>& template_names) {
+    for (const auto& template_name : template_names) {
+        try {
+            const TemplateDependencies& dependencies = config.getTemplateDependencies(template_name);
+            if (dependencies.dynamic || dependencies.reads("site.pages")) {
+                return true;
             }
-            else if (raw_tags.is_string()) {
-                std::string tag = raw_tags.get<std::string>();
-                if (!tag.empty() && seen_tags.insert(tag).second) {
-                    std::string slug = slugify(tag);
-                    all_tags.try_emplace(slug, nlohmann::json::object());
-                    nlohmann::json& tag_entry = all_tags[slug];
-                    if (!tag_entry.contains("name")) {
-                        tag_entry["name"] = tag;
-                        tag_entry["slug"] = slug;
-                        tag_entry["count"] = 0;
-                    }
-                    tag_entry["count"] = tag_entry["count"].get<std::size_t>() + 1;
-                    normalized_tags.push_back(tag);
+            for (const auto& variable : dependencies.variables) {
+                std::string head = variable.substr(0, variable.find('.'));
+                // the whole site, the top level pages list or a tag's pages
+                if (variable == "site" || (head != "site" && head != "page" && head != "theme")) {
+                    return true;
                 }
             }
-            else {
-                LOG_WARN("Unsupported tags frontmatter value detected; expected an array or string");
-            }
         }
-
-        if (normalized_tags.empty()) {
-            page_data.set<nlohmann::json>(nlohmann::json::array(), "tags");
-        }
-        else {
-            page_data.set<std::vector<std::string>>(normalized_tags, "tags");
+        catch (const std::exception&) {
+            return true;
         }
     }
+    return false;
+}
 
-    std::vector<nlohmann::json> sorted_tags;
-    sorted_tags.reserve(all_tags.size());
-    for (auto& [_, tag_entry] : all_tags) {
-        sorted_tags.push_back(tag_entry);
+Manifest::Entry Builder::manifest_entry(Page& page, Config& config) {
+    Manifest::Entry entry;
+    entry.hash = utils::to_hex(page.getSource().hash);
+    entry.templates = { page.getRecord().template_name };
+    entry.template_hash = hash_templates(config, entry.templates);
+    entry.outputs = { config.getOutput().relative(page.getRecord().path) };
+    return entry;
+}
+
+bool Builder::matches_previous(const Page& page, Config& config, const Manifest::Entry& entry) {
+    if (!previous_manifest) {
+        return false;
     }
 
-    std::sort(
-        sorted_tags.begin(),
-        sorted_tags.end(),
-        [](const nlohmann::json& a, const nlohmann::json& b) {
-            return a["name"].get<std::string>() < b["name"].get<std::string>();
+    std::string source = page.getSource().path.lexically_relative(config.getSiteDirectory()).generic_string();
+    const Manifest::Entry* previous_entry = previous_manifest->find(source);
+
+    return previous_entry
+        && previous_entry->hash == entry.hash
+        && previous_entry->templates == entry.templates
+        && !entry.template_hash.empty()
+        && previous_entry->template_hash == entry.template_hash
+        && previous_entry->outputs == entry.outputs
+        && config.getOutput().exists(config.getOutputDirectory() / entry.outputs.front());
+}
+
+void Builder::render_if_independent(Page& page, Config& config) {
+    const std::string& template_name = page.getRecord().template_name;
+
+    try {
+        if (reads_site_aggregates(config.getTemplateDependencies(template_name))) {
+            return;
         }
-    );
+    }
+    catch (const std::exception&) {
+        // left for the render phase, which reports the error
+        return;
+    }
 
-    for (auto& page : processed_pages) {
-        page.getPageData().set<nlohmann::json>(sorted_tags, "all_tags");
-        config.getData().add(page.getPageData(), "pages");
+    // the page sees only its own data and the config, so the config and template hashes cover everything else
+    if (config_unchanged && matches_previous(page, config, manifest_entry(page, config))) {
+        config.getOutput().record(page.getRecord().path);
+        ++kept_pages;
     }
+    else {
+        render_page(page, config, live_reload_snippet);
+        ++early_pages;
+    }
+    page.setRendered(true);
+}
 
-    config.getData().set<nlohmann::json>(sorted_tags, "site", "all_tags");
+void Builder::render_page(Page& page, Config& config, const std::string& snippet) {
+    try {
+        page.render(config, snippet);
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("Error rendering page: " << page.getSource().path);
+        LOG_ERROR("Error message: "        << e.what());
+    }
 }
 
-void Builder::sort_and_store_pages(Config& config) {
-    nlohmann::json pages = config.getData().getJson()["pages"];
-    std::sort(
-        pages.begin(), pages.end(),
-        [](const nlohmann::json& a, const nlohmann::json& b) {
-            return static_cast<time_t>(a["timestamp"]) > static_cast<time_t>(b["timestamp"]);
+void Builder::check_up_to_date(std::vector<Page>& processed_pages, Config& config, Manifest& manifest) {
+    bool site_unchanged = config_unchanged && previous_manifest->getSiteHash() == manifest.getSiteHash();
+    bool bodies_unchanged = site_unchanged && previous_manifest->getPagesHash() == manifest.getPagesHash();
+
+    std::size_t pending_pages = 0;
+    for (auto& page : processed_pages) {
+        Manifest::Entry entry = manifest_entry(page, config);
+
+        if (!page.isRendered()) {
+            bool inputs_unchanged = bodies_unchanged || (site_unchanged && !reads_page_bodies(config, entry.templates));
+            if (inputs_unchanged && matches_previous(page, config, entry)) {
+                config.getOutput().record(config.getOutputDirectory() / entry.outputs.front());
+                page.setRendered(true);
+                ++kept_pages;
+            }
+            else {
+                ++pending_pages;
+            }
         }
+
+        std::string source = page.getSource().path.lexically_relative(config.getSiteDirectory()).generic_string();
+        manifest.set(source, std::move(entry));
+    }
+
+    LOG_INFO(
+        "Pages: " << early_pages.load() << " rendered during content processing, "
+        << kept_pages.load() << " unchanged, " << pending_pages << " left to render"
     );
-    config.getData().set<nlohmann::json>(pages, "site", "pages");
 }
 
-void Builder::render_pages(std::vector<Page>& processed_pages, Config& config) {
-    for (auto& page : processed_pages) {
-        page.render(config, live_reload_snippet);
+void Builder::remove_stale_outputs(Config& config, const Manifest& previous, const std::set<std::string>& written) {
+    std::filesystem::path output_dir = config.getOutputDirectory();
+    for (const auto& output : previous.getOutputs()) {
+        if (written.find(output) != written.end()) {
+            continue;
+        }
+
+        std::filesystem::path stale_path = output_dir / output;
+        try {
+            config.getOutput().remove(stale_path);
+            LOG_INFO("Removed stale output: " << stale_path);
+        }
+        catch (const std::exception& e) {
+            LOG_WARN("Failed to remove stale output: " << e.what());
+        }
     }
 }
 
@@ -333,11 +646,7 @@ void Builder::copy_theme_assets(Config& config) {
     std::filesystem::path build_dir = config.getSiteDirectory() / "output";
     std::filesystem::path target_assets_dir = build_dir / relative_path;
 
-    std::filesystem::copy(
-        assets_dir,
-        target_assets_dir,
-        std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing
-    );
+    copy_directory(config, assets_dir, target_assets_dir);
 }
 
 void Builder::copy_assets(Config& config) {
@@ -346,29 +655,38 @@ void Builder::copy_assets(Config& config) {
     std::filesystem::path build_dir = config.getSiteDirectory() / "output";
     std::filesystem::path target_assets_dir = build_dir / relative_path / "assets";
 
-    std::filesystem::copy(
-        assets_dir,
-        target_assets_dir,
-        std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing
-    );
+    copy_directory(config, assets_dir, target_assets_dir);
 }
 
-std::size_t Builder::count_words(const std::string_view& text) {
-    bool in_word = false;
-    std::size_t count = 0;
+void Builder::copy_directory(Config& config, const std::filesystem::path& source_dir, const std::filesystem::path& target_dir) {
+    if (!std::filesystem::is_directory(source_dir)) {
+        throw std::runtime_error("Assets directory not found: " + source_dir.string());
+    }
 
-    for (char ch : text) {
-        unsigned char uch = static_cast<unsigned char>(ch);
-        if (std::isalnum(uch)) {
-            if (!in_word) {
-                in_word = true;
-                ++count;
-            }
+    // directories first, so the file copies can run in any order
+    std::vector<std::filesystem::path> files;
+    config.getOutput().create_directories(target_dir);
+    // a server session only copies what it was told has changed
+    auto unchanged = [this, &config](const std::filesystem::path& source, const std::filesystem::path& target) {
+        return session && !session->isChanged(source) && config.getOutput().exists(target);
+    };
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(source_dir)) {
+        std::filesystem::path target = target_dir / entry.path().lexically_relative(source_dir);
+        if (entry.is_directory()) {
+            config.getOutput().create_directories(target);
         }
-        else {
-            in_word = false;
+        else if (entry.is_regular_file()) {
+            files.push_back(entry.path());
         }
     }
 
-    return count;
+    utils::parallel_for(pool, files.size(), [&config, &files, &source_dir, &target_dir, &unchanged](std::size_t idx) {
+        std::filesystem::path target = target_dir / files[idx].lexically_relative(source_dir);
+        if (unchanged(files[idx], target)) {
+            config.getOutput().record(target);
+            return;
+        }
+        config.getOutput().copy(files[idx], target);
+    });
 }
@@ -4,43 +4,84 @@
 #include "../data/config.hpp"
 #include "page.hpp"
 #include "feeder.hpp"
+#include "manifest.hpp"
+#include "markdown_cache.hpp"
+#include "build_session.hpp"
+#include "../utils/thread_pool.hpp"
 #include <inja.hpp>
 #include <vector>
-#include <queue>
 #include <string>
-#include <thread>
+#include <set>
 #include <mutex>
-#include <condition_variable>
-#include <future>
+#include <atomic>
 
 class Builder {
 private:
     Feeder& feeder;
+    ThreadPool& pool;
     std::string live_reload_snippet;
+    MarkdownCache markdown_cache;
+    BuildSession* session;
 
-    std::pair<std::string, std::string> read_and_extract(const std::filesystem::path& page_path);
-    std::string generate_html(const std::string_view& markdown);
-    std::size_t count_words(const std::string_view& text);
+    // state of the current build, shared with the content threads
+    const Manifest* previous_manifest = nullptr;
+    bool config_unchanged = false;
+    std::atomic<std::size_t> early_pages{ 0 };
+    std::atomic<std::size_t> kept_pages{ 0 };
 
-    void content_worker_thread(std::vector<Page>& processed_pages, std::mutex& processed_pages_mutex);
+    // both views point into buffer, which is reused between pages by the caller
+    std::pair<std::string_view, std::string_view> read_and_extract(const std::filesystem::path& page_path, std::string& buffer);
+    // the rendered markdown as the page's content and word_count, and its reading_time,
+    // excerpt and toc where the frontmatter does not set them
+    static void set_content(Data& page_data, RenderedMarkdown content);
+    MarkdownCache markdownCacheFactory(Config& config);
+
+    void content_worker(std::vector<Page>& processed_pages, std::mutex& processed_pages_mutex);
+    // null when the file turned out to match the known source
+    std::shared_ptr<BuildSession::Source> parse_source(
+        const std::filesystem::path& page_path,
+        std::string& buffer,
+        const std::shared_ptr<const BuildSession::Source>& known
+    );
     //void content_worker_thread(std::vector<Page>& processed_pages);
     //void render_worker_thread(std::vector<Page>& processed_pages, Config& config, std::atomic<size_t>& next_idx);
 
-    void start_content_threads(unsigned int num_threads, std::vector<Page>& processed_pages);
-    void start_render_threads(unsigned int num_threads, std::vector<Page>& processed_pages, Config& config);
+    void run_content_tasks(std::vector<Page>& processed_pages);
+    void run_render_tasks(std::vector<Page>& processed_pages, Config& config);
     //void start_render_worker_threads(unsigned int num_threads, std::vector<Page>& processed_pages, Config& config);
 
-    void collect_and_validate_pages(std::vector<Page>& processed_pages, Config& config);
-    void sort_and_store_pages(Config& config);
-    void process_directives(Config& config);
-    void render_pages(std::vector<Page>& processed_pages, Config& config);
+    void prepare_page(Page& page, Config& config);
+    void collect_pages(std::vector<Page>& processed_pages, Config& config);
+    // orders site.pages newest first and fills the tag index in that order
+    void sort_and_store_pages(std::vector<Page>& processed_pages, Config& config);
+    void process_directives(Config& config, Manifest& manifest);
     void copy_theme_assets(Config& config);
     void copy_assets(Config& config);
+    void copy_directory(Config& config, const std::filesystem::path& source_dir, const std::filesystem::path& target_dir);
+
+    bool reads_site_aggregates(const TemplateDependencies& dependencies);
+    // whether any of the templates can print what other pages' markdown bodies turned into
+    bool reads_page_bodies(Config& config, const std::vector<std::string>& template_names);
+    void render_if_independent(Page& page, Config& config);
+    void render_page(Page& page, Config& config, const std::string& snippet);
+
+    // the config and every page's frontmatter, and with bodies set, every page's markdown too
+    std::string hash_site_inputs(const std::vector<Page>& processed_pages, Config& config, const std::string& config_hash, bool bodies);
+    // empty if one of the templates fails to load
+    std::string hash_templates(Config& config, const std::vector<std::string>& template_names);
+    bool matches_templates(Config& config, const Manifest::Entry& previous_entry);
+    Manifest::Entry manifest_entry(Page& page, Config& config);
+    bool matches_previous(const Page& page, Config& config, const Manifest::Entry& entry);
+    void check_up_to_date(std::vector<Page>& processed_pages, Config& config, Manifest& manifest);
+    void remove_stale_outputs(Config& config, const Manifest& previous, const std::set<std::string>& written);
 public:
     void build();
 
-    Builder(Feeder& feeder, const std::string& live_reload_snippet = "");
+    // with a session, only the files it reports as changed are read and parsed again
+    Builder(Feeder& feeder, ThreadPool& pool, const std::string& live_reload_snippet = "", BuildSession* session = nullptr);
     ~Builder();
+
+    static constexpr unsigned MD_PARSER_FLAGS = 0;
 };
 
 #endif
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "feeder.hpp"
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 
-Feeder::Feeder(Config& config) :
-    config(config), counter(0)
+Feeder::Feeder(Config& config, ThreadPool& pool) :
+    config(config), pool(pool)
 {
     fetchPosts();
 }
@@ -16,29 +20,34 @@ void Feeder::fetchPosts() {
         throw std::runtime_error(ss.str());
     }
 
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(content_dir)) {
-        if (std::filesystem::is_regular_file(entry.status())) {
-            LOG_INFO("Queueing content: " << entry.path());
-            page_queue.push(entry.path());
+    // one task per directory; results are merged once per directory, not per file
+    std::mutex pages_mutex;
+    TaskGroup group(pool);
+    std::function<void(std::filesystem::path)> scan = [&](std::filesystem::path dir) {
+        std::vector<std::filesystem::path> found;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            if (std::filesystem::is_directory(entry.symlink_status())) {
+                group.submit([&scan, subdir = entry.path()] { scan(subdir); });
+            }
+            else if (std::filesystem::is_regular_file(entry.status())) {
+                found.push_back(entry.path());
+            }
         }
-    }
-    if (std::filesystem::is_empty(content_dir)) { } // TODO
-}
 
-bool Feeder::isQueueEmpty() {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    return page_queue.empty();
-}
+        std::lock_guard<std::mutex> lock(pages_mutex);
+        pages.insert(pages.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    };
+    group.submit([&scan, content_dir] { scan(content_dir); });
+    group.wait();
 
-std::optional<std::pair<std::int32_t, std::filesystem::path>> Feeder::getNext() {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    // a stable order keeps content indices and logs comparable between builds
+    std::sort(pages.begin(), pages.end());
+    cursor.store(0);
 
-    if (page_queue.empty()) {
-        return std::nullopt;
-    }
-    
-    std::filesystem::path next_path = page_queue.front();
-    page_queue.pop();
-    ++counter;
-    return std::pair<std::int32_t, std::filesystem::path>(counter, next_path);
+    LOG_INFO("Queued " << pages.size() << " content files");
+}
+
+std::pair<std::size_t, std::size_t> Feeder::claim(std::size_t count) {
+    std::size_t first = std::min(cursor.fetch_add(count, std::memory_order_relaxed), pages.size());
+    return { first, std::min(first + count, pages.size()) };
 }
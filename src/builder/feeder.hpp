@@ -2,28 +2,32 @@
 #define FEEDER_HPP_
 
 #include "../data/config.hpp"
-#include <queue>
+#include "../utils/thread_pool.hpp"
+#include <atomic>
 #include <filesystem>
-#include <mutex>
-#include <condition_variable>
-#include <optional>
+#include <utility>
+#include <vector>
 
 class Feeder {
 private:
     Config& config;
-    std::mutex queue_mutex;
-    std::queue<std::filesystem::path> page_queue;
+    ThreadPool& pool;
+    // every content file, sorted; filled once by fetchPosts and read-only afterwards
+    std::vector<std::filesystem::path> pages;
+    std::atomic<std::size_t> cursor{ 0 };
 
 public:
-    int counter;
-    Feeder(Config& config);
+    Feeder(Config& config, ThreadPool& pool);
     void fetchPosts();
 
     Config& getConfig() { return config; }
-    std::mutex& getQueueMutex() { return queue_mutex; }
 
-    std::optional<std::pair<std::int32_t, std::filesystem::path>> getNext();
-    bool isQueueEmpty();
+    std::size_t size() const { return pages.size(); }
+    const std::filesystem::path& getPath(std::size_t index) const { return pages[index]; }
+
+    // claims the next count unclaimed pages as the index range [first, second);
+    // the range is empty once every page has been handed out
+    std::pair<std::size_t, std::size_t> claim(std::size_t count = 1);
 };
 
 #endif
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <stdexcept>
+
+#include "frontmatter.hpp"
+
+namespace {
+    using json = nlohmann::json;
+
+    constexpr std::size_t npos = std::string_view::npos;
+
+    // kept in the page data whatever the templates read, as validate() and the
+    // directives look at them or fill them in
+    const std::set<std::string> BUILDER_KEYS = {
+        "title", "description", "excerpt", "date", "template", "tags", "indexable", "show_description"
+    };
+
+    bool retained(const std::string& key, const std::set<std::string>* keys) {
+        return !keys || keys->count(key) || BUILDER_KEYS.count(key);
+    }
+
+    // checks one JSON value without building it; only a string at its top is kept
+    class ValueReader : public json::json_sax_t {
+    private:
+        std::size_t depth = 0;
+
+    public:
+        std::string text;                   // the value, if it is a string
+        std::string error;
+        std::size_t error_position = 0;
+
+        bool null() override { return true; }
+        bool boolean(bool) override { return true; }
+        bool number_integer(json::number_integer_t) override { return true; }
+        bool number_unsigned(json::number_unsigned_t) override { return true; }
+        bool number_float(json::number_float_t, const json::string_t&) override { return true; }
+        bool binary(json::binary_t&) override { return true; }
+
+        bool string(json::string_t& value) override {
+            if (depth == 0) {
+                text = std::move(value);
+            }
+            return true;
+        }
+
+        bool start_object(std::size_t) override { ++depth; return true; }
+        bool key(json::string_t&) override { return true; }
+        bool end_object() override { --depth; return true; }
+        bool start_array(std::size_t) override { ++depth; return true; }
+        bool end_array() override { --depth; return true; }
+
+        bool parse_error(std::size_t position, const std::string&, const json::exception& e) override {
+            error = e.what();
+            error_position = position;
+            return false;
+        }
+    };
+
+    [[noreturn]] void fail(const std::string& message, std::size_t position) {
+        std::ostringstream ss;
+        ss << "Error parsing frontmatter at byte " << position << ": " << message;
+        throw std::runtime_error(ss.str());
+    }
+
+    void read(std::string_view text, std::size_t offset, std::size_t length, ValueReader& reader) {
+        std::string_view value = text.substr(offset, length);
+        if (!json::sax_parse(value.begin(), value.end(), &reader)) {
+            fail(reader.error, offset + reader.error_position);
+        }
+    }
+
+    json parse(std::string_view text, std::size_t offset, std::size_t length) {
+        std::string_view value = text.substr(offset, length);
+        try {
+            return json::parse(value.begin(), value.end());
+        }
+        catch (const json::parse_error& e) {
+            fail(e.what(), offset + e.byte);
+        }
+    }
+
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    std::size_t skip_space(std::string_view text, std::size_t pos) {
+        while (pos < text.size() && is_space(text[pos])) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    // just past the string starting at pos, or npos if it is not closed
+    std::size_t string_end(std::string_view text, std::size_t pos) {
+        for (++pos; pos < text.size(); ++pos) {
+            if (text[pos] == '\\') {
+                ++pos;
+            }
+            else if (text[pos] == '"') {
+                return pos + 1;
+            }
+        }
+        return npos;
+    }
+
+    // just past the value starting at pos, found by matching quotes and brackets;
+    // the value itself is checked when it is read
+    std::size_t value_end(std::string_view text, std::size_t pos) {
+        std::size_t depth = 0;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '"') {
+                pos = string_end(text, pos);
+                if (pos == npos || depth == 0) {
+                    return pos;
+                }
+                continue;
+            }
+
+            if (c == '{' || c == '[') {
+                ++depth;
+            }
+            else if (c == '}' || c == ']') {
+                if (depth == 0) {
+                    return pos;
+                }
+                if (--depth == 0) {
+                    return pos + 1;
+                }
+            }
+            else if (depth == 0 && (c == ',' || is_space(c))) {
+                return pos;
+            }
+            ++pos;
+        }
+        return depth == 0 ? pos : npos;
+    }
+}
+
+Frontmatter::Frontmatter(std::string_view text, const std::set<std::string>* keys, bool keep_unparsed) {
+    std::size_t pos = skip_space(text, 0);
+    if (pos >= text.size() || text[pos] != '{') {
+        fail("expected a JSON object", pos);
+    }
+
+    pos = skip_space(text, pos + 1);
+    bool closed = pos < text.size() && text[pos] == '}';
+    if (closed) {
+        ++pos;
+    }
+
+    while (!closed) {
+        if (pos >= text.size() || text[pos] != '"') {
+            fail("expected a key", pos);
+        }
+        std::size_t key_end = string_end(text, pos);
+        if (key_end == npos) {
+            fail("unterminated key", pos);
+        }
+
+        ValueReader key_reader;
+        read(text, pos, key_end - pos, key_reader);
+
+        pos = skip_space(text, key_end);
+        if (pos >= text.size() || text[pos] != ':') {
+            fail("expected ':' after key '" + key_reader.text + "'", pos);
+        }
+        pos = skip_space(text, pos + 1);
+
+        std::size_t end = value_end(text, pos);
+        if (end == npos || end == pos) {
+            fail("expected a value for key '" + key_reader.text + "'", pos);
+        }
+
+        const std::string& key = key_reader.text;
+        if (retained(key, keys)) {
+            json& value = values[key];
+            value = parse(text, pos, end - pos);
+            readBuilderKey(key, value);
+        }
+        else {
+            ValueReader reader;
+            read(text, pos, end - pos, reader);
+            if (keep_unparsed) {
+                unparsed[key] = std::string(text.substr(pos, end - pos));
+            }
+        }
+        names.push_back(std::move(key_reader.text));
+
+        pos = skip_space(text, end);
+        if (pos < text.size() && text[pos] == ',') {
+            pos = skip_space(text, pos + 1);
+        }
+        else if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            closed = true;
+        }
+        else {
+            fail("expected ',' or '}'", pos);
+        }
+    }
+
+    if (skip_space(text, pos) != text.size()) {
+        fail("unexpected text after the object", pos);
+    }
+}
+
+void Frontmatter::readBuilderKey(const std::string& key, const json& value) {
+    if (key == "date") {
+        date = value.is_string() ? std::optional<std::string>(value.get<std::string>()) : std::nullopt;
+    }
+    else if (key == "template") {
+        template_name = value.is_string() ? std::optional<std::string>(value.get<std::string>()) : std::nullopt;
+    }
+    else if (key == "indexable") {
+        indexable = value.is_boolean() ? std::optional<bool>(value.get<bool>()) : std::nullopt;
+    }
+    else if (key == "tags") {
+        tags.clear();
+        ignored_tags = 0;
+        if (value.is_string()) {
+            tags_form = TagsForm::String;
+            tags.push_back(value.get<std::string>());
+        }
+        else if (value.is_array()) {
+            tags_form = TagsForm::Array;
+            for (const auto& item : value) {
+                if (item.is_string()) {
+                    tags.push_back(item.get<std::string>());
+                }
+                else {
+                    ++ignored_tags;
+                }
+            }
+        }
+        else {
+            tags_form = TagsForm::Other;
+        }
+    }
+}
+
+bool Frontmatter::has(std::string_view key) const {
+    return std::find(names.begin(), names.end(), key) != names.end();
+}
+
+nlohmann::json Frontmatter::toJson(const std::set<std::string>* keys) const {
+    if (!keys) {
+        json result = values;
+        for (const auto& [key, value] : unparsed) {
+            result[key] = json::parse(value);
+        }
+        return result;
+    }
+
+    json result = json::object();
+    for (const auto& [key, value] : values.items()) {
+        if (retained(key, keys)) {
+            result[key] = value;
+        }
+    }
+    for (const auto& [key, value] : unparsed) {
+        if (retained(key, keys)) {
+            // checked when it was read, so this cannot fail
+            result[key] = json::parse(value);
+        }
+    }
+    return result;
+}
+
+nlohmann::json Frontmatter::takeJson() {
+    return std::exchange(values, json::object());
+}
@@ -0,0 +1,53 @@
+#ifndef FRONTMATTER_HPP_
+#define FRONTMATTER_HPP_
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../utils/debug.hpp"
+
+// A page's frontmatter, read one top-level value at a time. Values the page data keeps
+// are parsed into JSON as they are read; the rest only go through nlohmann's SAX parser
+// to be checked. The keys the builder works with also land in typed fields.
+class Frontmatter {
+public:
+    enum class TagsForm { Missing, String, Array, Other };
+
+    // set when the key holds a value of the expected type
+    std::optional<std::string> date;
+    std::optional<std::string> template_name;
+    std::optional<bool> indexable;
+    TagsForm tags_form = TagsForm::Missing;
+    std::vector<std::string> tags;          // as written, for a string or the strings of an array
+    std::size_t ignored_tags = 0;           // entries of a tags array that are not strings
+
+private:
+    std::vector<std::string> names;                 // every key, as written
+    nlohmann::json values = nlohmann::json::object();
+    std::map<std::string, std::string> unparsed;    // the other values' text, when kept
+
+public:
+    Frontmatter() = default;
+    // throws if text is not a JSON object. The values of keys, and of the keys the
+    // builder itself reads or fills in, are parsed once, straight into JSON; every
+    // key when keys is null. The text of the other values is only held on to with
+    // keep_unparsed, for a later toJson() that asks for more keys.
+    Frontmatter(std::string_view text, const std::set<std::string>* keys, bool keep_unparsed);
+
+    bool has(std::string_view key) const;
+    // copies the values of keys and of the keys the builder uses; every value when
+    // keys is null. Unparsed values that were not kept are left out.
+    nlohmann::json toJson(const std::set<std::string>* keys = nullptr) const;
+    // moves out the values parsed by the constructor; the typed fields stay
+    nlohmann::json takeJson();
+
+private:
+    void readBuilderKey(const std::string& key, const nlohmann::json& value);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "manifest.hpp"
+#include "../utils/utils.hpp"
+
+Manifest::Manifest(const std::filesystem::path& state_dir) :
+    file_path(state_dir / FILE_NAME)
+{
+}
+
+bool Manifest::load() {
+    std::string text;
+    if (!std::filesystem::exists(file_path) || !utils::read_file(file_path, text)) {
+        return false;
+    }
+
+    try {
+        nlohmann::json manifest = nlohmann::json::parse(text);
+        if (manifest.value("version", 0) != VERSION) {
+            LOG_WARN("Ignoring build manifest written by a different version: " << file_path);
+            return false;
+        }
+
+        config_hash = manifest.at("config_hash").get<std::string>();
+        site_hash = manifest.at("site_hash").get<std::string>();
+        pages_hash = manifest.at("pages_hash").get<std::string>();
+        outputs = manifest.at("outputs").get<std::set<std::string>>();
+
+        for (const auto& [source, value] : manifest.at("pages").items()) {
+            Entry entry;
+            entry.hash = value.at("hash").get<std::string>();
+            entry.templates = value.at("templates").get<std::vector<std::string>>();
+            entry.template_hash = value.at("template_hash").get<std::string>();
+            entry.outputs = value.at("outputs").get<std::vector<std::string>>();
+            entries.emplace(source, std::move(entry));
+        }
+
+        for (const auto& [key, value] : manifest.at("directives").items()) {
+            Entry entry;
+            entry.hash = value.at("hash").get<std::string>();
+            entry.templates = value.at("templates").get<std::vector<std::string>>();
+            entry.template_hash = value.at("template_hash").get<std::string>();
+            entry.outputs = value.at("outputs").get<std::vector<std::string>>();
+            directives.emplace(key, std::move(entry));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("Ignoring unreadable build manifest " << file_path << ": " << e.what());
+        entries.clear();
+        directives.clear();
+        outputs.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool Manifest::save() const {
+    nlohmann::json manifest;
+    manifest["version"] = VERSION;
+    manifest["config_hash"] = config_hash;
+    manifest["site_hash"] = site_hash;
+    manifest["pages_hash"] = pages_hash;
+    manifest["outputs"] = outputs;
+
+    nlohmann::json pages = nlohmann::json::object();
+    for (const auto& [source, entry] : entries) {
+        pages[source] = {
+            { "hash", entry.hash },
+            { "templates", entry.templates },
+            { "template_hash", entry.template_hash },
+            { "outputs", entry.outputs }
+        };
+    }
+    manifest["pages"] = std::move(pages);
+
+    nlohmann::json directive_entries = nlohmann::json::object();
+    for (const auto& [key, entry] : directives) {
+        directive_entries[key] = {
+            { "hash", entry.hash },
+            { "templates", entry.templates },
+            { "template_hash", entry.template_hash },
+            { "outputs", entry.outputs }
+        };
+    }
+    manifest["directives"] = std::move(directive_entries);
+
+    std::filesystem::path writable_path = file_path;
+    return utils::output_file(manifest.dump(), writable_path);
+}
+
+void Manifest::discard() const {
+    std::error_code ec;
+    std::filesystem::remove(file_path, ec);
+    if (ec) {
+        LOG_WARN("Failed to remove build manifest " << file_path << ": " << ec.message());
+    }
+}
+
+const Manifest::Entry* Manifest::find(const std::string& source) const {
+    auto it = entries.find(source);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+const Manifest::Entry* Manifest::findDirective(const std::string& key) const {
+    auto it = directives.find(key);
+    return it != directives.end() ? &it->second : nullptr;
+}
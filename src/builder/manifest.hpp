@@ -0,0 +1,59 @@
+#ifndef MANIFEST_HPP_
+#define MANIFEST_HPP_
+
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../utils/debug.hpp"
+
+// What a build produced, persisted between runs so the next build can skip
+// pages whose inputs did not change and delete only the outputs that went stale.
+class Manifest {
+public:
+    struct Entry {
+        std::string hash;                   // source content hash
+        std::vector<std::string> templates; // template names used to render the page
+        std::string template_hash;          // those templates and everything they include or extend
+        std::vector<std::string> outputs;   // relative to the output directory
+    };
+
+private:
+    std::filesystem::path file_path;
+    std::string config_hash;
+    std::string site_hash;
+    std::string pages_hash;
+    std::map<std::string, Entry> entries;   // keyed by source path relative to the site directory
+    std::map<std::string, Entry> directives;// keyed by position and name
+    std::set<std::string> outputs;          // every file the build wrote or kept
+
+public:
+    explicit Manifest(const std::filesystem::path& state_dir);
+
+    // returns false if there is no usable manifest, in which case the build must start clean
+    bool load();
+    bool save() const;
+    // removes the file on disk, so a build that stops halfway is followed by a clean one
+    void discard() const;
+
+    const Entry*                    find(const std::string& source) const;
+    void                            set(const std::string& source, Entry entry) { entries[source] = std::move(entry); }
+    const Entry*                    findDirective(const std::string& key) const;
+    void                            setDirective(const std::string& key, Entry entry) { directives[key] = std::move(entry); }
+
+    const std::string&              getConfigHash() const { return config_hash; }
+    void                            setConfigHash(const std::string& hash) { config_hash = hash; }
+    const std::string&              getSiteHash() const { return site_hash; }
+    void                            setSiteHash(const std::string& hash) { site_hash = hash; }
+    const std::string&              getPagesHash() const { return pages_hash; }
+    void                            setPagesHash(const std::string& hash) { pages_hash = hash; }
+    const std::set<std::string>&    getOutputs() const { return outputs; }
+    void                            setOutputs(std::set<std::string> written) { outputs = std::move(written); }
+
+    static constexpr const char* FILE_NAME = "manifest";
+    static constexpr int VERSION = 6;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "markdown_cache.hpp"
+#include "../utils/utils.hpp"
+
+MarkdownCache::MarkdownCache(const std::filesystem::path& cache_dir, std::uintmax_t max_size, unsigned parser_flags) :
+    cache_dir(cache_dir),
+    max_size(max_size),
+    parser_flags(parser_flags)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+    if (ec) {
+        LOG_WARN("Markdown cache disabled, failed to create " << cache_dir << ": " << ec.message());
+        this->max_size = 0;
+    }
+}
+
+std::filesystem::path MarkdownCache::entryPath(std::string_view markdown) const {
+    std::ostringstream salt;
+    salt << FORMAT_VERSION << ':' << parser_flags << ':';
+
+    // two differently seeded passes give a 128-bit key
+    std::uint64_t first = utils::hash(markdown, utils::hash(salt.str()));
+    std::uint64_t second = utils::hash(markdown, utils::hash(salt.str(), first));
+    return cache_dir / (utils::to_hex(first) + utils::to_hex(second));
+}
+
+std::optional<MarkdownCache::Entry> MarkdownCache::find(std::string_view markdown) {
+    if (!enabled()) {
+        return std::nullopt;
+    }
+
+    std::filesystem::path path = entryPath(markdown);
+    std::string content;
+    if (!std::filesystem::exists(path) || !utils::read_file(path, content)) {
+        ++misses;
+        return std::nullopt;
+    }
+
+    // header: <markdown size> <word count>\n, then the excerpt and headings as one
+    // line of JSON, followed by the html
+    std::size_t header_end = content.find('\n');
+    std::size_t analysis_end = header_end == std::string::npos ? header_end : content.find('\n', header_end + 1);
+    std::istringstream header(content.substr(0, header_end));
+    std::size_t markdown_size = 0;
+    Entry entry;
+    if (analysis_end == std::string::npos || !(header >> markdown_size >> entry.word_count) || markdown_size != markdown.size()) {
+        ++misses;
+        return std::nullopt;
+    }
+
+    try {
+        nlohmann::json analysis = nlohmann::json::parse(content.begin() + header_end + 1, content.begin() + analysis_end);
+        entry.excerpt = analysis.at("excerpt").get<std::string>();
+        for (const auto& item : analysis.at("toc")) {
+            entry.toc.push_back({ item.at(0).get<int>(), item.at(1).get<std::string>(), item.at(2).get<std::string>() });
+        }
+    } catch (const nlohmann::json::exception&) {
+        ++misses;
+        return std::nullopt;
+    }
+    entry.html = content.substr(analysis_end + 1);
+
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+    ++hits;
+    return entry;
+}
+
+void MarkdownCache::store(std::string_view markdown, const Entry& entry) {
+    if (!enabled()) {
+        return;
+    }
+
+    nlohmann::json toc = nlohmann::json::array();
+    for (const auto& heading : entry.toc) {
+        toc.push_back({ heading.level, heading.id, heading.title });
+    }
+    std::string analysis;
+    try {
+        analysis = nlohmann::json{ { "excerpt", entry.excerpt }, { "toc", std::move(toc) } }.dump();
+    } catch (const nlohmann::json::exception&) {
+        // text that is not valid UTF-8 is left out of the cache rather than altered
+        return;
+    }
+
+    std::filesystem::path path = entryPath(markdown);
+    std::ostringstream tmp_name;
+    tmp_name << path.filename().string() << ".tmp" << std::this_thread::get_id();
+    std::filesystem::path tmp_path = cache_dir / tmp_name.str();
+
+    {
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return;
+        }
+        out << markdown.size() << ' ' << entry.word_count << '\n' << analysis << '\n' << entry.html;
+        if (!out.good()) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+
+    // rename is atomic, so concurrent builds never see a partial entry
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+
+void MarkdownCache::trim() {
+    if (!enabled()) {
+        return;
+    }
+
+    struct CachedFile {
+        std::filesystem::path path;
+        std::filesystem::file_time_type last_used;
+        std::uintmax_t size;
+    };
+
+    std::vector<CachedFile> files;
+    std::uintmax_t total_size = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir, ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        CachedFile file{ entry.path(), entry.last_write_time(ec), entry.file_size(ec) };
+        if (ec) {
+            ec.clear();
+            continue;
+        }
+        total_size += file.size;
+        files.push_back(std::move(file));
+    }
+
+    if (total_size <= max_size) {
+        return;
+    }
+
+    std::sort(files.begin(), files.end(), [](const CachedFile& a, const CachedFile& b) {
+        return a.last_used < b.last_used;
+    });
+
+    std::size_t evicted = 0;
+    for (const auto& file : files) {
+        if (total_size <= max_size) {
+            break;
+        }
+        if (std::filesystem::remove(file.path, ec)) {
+            total_size -= file.size;
+            ++evicted;
+        }
+    }
+
+    LOG_INFO("Evicted " << evicted << " markdown cache entries to stay under " << max_size / (1024 * 1024) << " MB");
+}
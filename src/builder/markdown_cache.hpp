@@ -0,0 +1,49 @@
+#ifndef MARKDOWN_CACHE_HPP_
+#define MARKDOWN_CACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "rendered_markdown.hpp"
+#include "../utils/debug.hpp"
+
+// On-disk cache of markdown conversions, one file per distinct markdown body.
+// Entries are keyed by the content and the md4c parser flags, so every build of the
+// site (CLI or server, any branch) can reuse them. Recency is tracked through
+// file modification times and the least recently used entries are evicted
+// once the cache grows past its size cap.
+class MarkdownCache {
+public:
+    using Entry = RenderedMarkdown;
+
+private:
+    std::filesystem::path cache_dir;
+    std::uintmax_t max_size;
+    unsigned parser_flags;
+
+    std::atomic<std::size_t> hits{ 0 };
+    std::atomic<std::size_t> misses{ 0 };
+
+    std::filesystem::path entryPath(std::string_view markdown) const;
+
+public:
+    // a max_size of 0 disables the cache
+    MarkdownCache(const std::filesystem::path& cache_dir, std::uintmax_t max_size, unsigned parser_flags);
+
+    std::optional<Entry> find(std::string_view markdown);
+    void store(std::string_view markdown, const Entry& entry);
+    // evicts least recently used entries until the cache fits its cap
+    void trim();
+
+    bool enabled() const { return max_size > 0; }
+    std::size_t getHits() const { return hits.load(); }
+    std::size_t getMisses() const { return misses.load(); }
+
+    static constexpr std::uintmax_t DEFAULT_MAX_SIZE_MB = 256;
+    static constexpr int FORMAT_VERSION = 2;
+};
+
+#endif
@@ -1,36 +1,54 @@
 #include <algorithm>
 #include <cctype>
-#include <iomanip>
+#include <string_view>
 #include "page.hpp"
 #include "../utils/utils.hpp"
+#include "../utils/date.hpp"
+#include "../data/render_context.hpp"
 #include "../builder/builder.hpp"
 #include "../directives/directive.hpp"
+#include "../utils/string_output.hpp"
 
-Page::Page(const Data& data)
-    : page_data(data)
+namespace {
+    // position of the last </body>, in any case, or npos
+    std::size_t find_body_end(const std::string& html) {
+        static constexpr std::string_view body_tag = "</body>";
+        if (html.size() < body_tag.size()) {
+            return std::string::npos;
+        }
+
+        for (std::size_t pos = html.size() - body_tag.size() + 1; pos-- > 0;) {
+            if (html[pos] != '<') {
+                continue;
+            }
+
+            std::size_t i = 1;
+            while (i < body_tag.size() && std::tolower(static_cast<unsigned char>(html[pos + i])) == body_tag[i]) {
+                ++i;
+            }
+            if (i == body_tag.size()) {
+                return pos;
+            }
+        }
+        return std::string::npos;
+    }
+}
+
+Page::Page(Data data, PageSource source)
+    : page_data(std::move(data)), source(std::move(source))
 {
 }
 
 void Page::render(Config& config, const std::string& live_reload_snippet) {
-    std::string template_name = page_data.get<std::string>("template");
-    inja::Environment& env = config.getEnvironment();
-    const inja::Template& temp = config.getTemplate(template_name);
-
-    nlohmann::json temp_data = config.getData().getJson();
-    temp_data["page"] = page_data.getJson();
+    RenderContext context(config.getData());
+    // page.all_tags is shared by every page rather than stored in each
+    context.bind("page", page_data.getJsonRef()).extend("page", config.getTagIndex().pageFields());
 
-    std::string result = env.render(temp, temp_data);
+    std::string& result = utils::render_buffer();
+    context.render_to(config, record.template_name, result);
 
     if (!live_reload_snippet.empty()) {
-        std::string lowered = result;
-        std::transform(
-            lowered.begin(),
-            lowered.end(),
-            lowered.begin(),
-            [](unsigned char c) { return static_cast<char>(std::tolower(c)); }
-        );
-        std::string body_tag = "</body>";
-        std::size_t pos = lowered.rfind(body_tag);
+        std::size_t pos = find_body_end(result);
 
         if (pos != std::string::npos) {
             result.insert(pos, live_reload_snippet);
@@ -39,9 +57,9 @@ void Page::render(Config& config, const std::string& live_reload_snippet) {
             result.append(live_reload_snippet);
         }
     }
-    std::filesystem::path output_path = page_data.get<std::string>("path");
+    std::filesystem::path output_path = record.path;
 
-    if (utils::output_file(result, output_path)) {
+    if (config.getOutput().write(result, output_path)) {
         LOG_INFO("Succefully outputted file: " << output_path);
     }
     else {
@@ -55,46 +73,69 @@ void Page::validate(Config& config) {
         page_data.set<std::string>(DEFAULT_PAGE_TITLE, "title");
     }
 
-    // TODO: generate description from content instead
+    // the excerpt taken while rendering stands in for a missing description
     if (!page_data.hasKey("description")) {
-        LOG_WARN("No description found in page frontmatter. Defaulting to: " << DEFAULT_PAGE_DESCRIPTION);
-        page_data.set<std::string>(DEFAULT_PAGE_DESCRIPTION, "description");
+        std::string excerpt = page_data.hasKey("excerpt") ? page_data.get<std::string>("excerpt") : "";
+        if (excerpt.empty()) {
+            LOG_WARN("No description found in page frontmatter. Defaulting to: " << DEFAULT_PAGE_DESCRIPTION);
+            page_data.set<std::string>(DEFAULT_PAGE_DESCRIPTION, "description");
+        }
+        else {
+            page_data.set<std::string>(std::move(excerpt), "description");
+        }
     }
 
-    if (!page_data.hasKey("date")) {
-        std::time_t t = std::time(nullptr);
-        std::tm tm = *std::localtime(&t);
+    // the frontmatter's typed fields, rather than lookups in page_data
+    const Frontmatter& frontmatter = source.frontmatter;
 
-        std::ostringstream oss;
-        oss << std::put_time(&tm, "%d-%m-%Y %H:%M");
-        
-        page_data.set<std::string>(oss.str(), "date");
+    std::string date;
+    if (!frontmatter.has("date")) {
+        date = utils::format_date(std::time(nullptr), config.getTimezoneOffset());
+        page_data.set<std::string>(date, "date");
+    }
+    else if (frontmatter.date.has_value()) {
+        date = frontmatter.date.value();
+    }
+    else {
+        throw std::runtime_error("Page date must be a string");
     }
 
-    if (!page_data.hasKey("indexable")) {
+    if (!frontmatter.has("indexable")) {
         page_data.set<bool>(true, "indexable");
     }
+    // anything but true keeps the page out of the index
+    record.indexable = frontmatter.has("indexable") ? frontmatter.indexable.value_or(false) : true;
 
     if (!page_data.hasKey("show_description")) {
         page_data.set<bool>(false, "show_description");
     }
 
-    if (!page_data.hasKey("template")) {
+    if (!frontmatter.has("template")) {
         if (config.getData().hasKey("theme", "default")) {
-            page_data.set<std::string>(
-                config.getData().get<std::string>("theme", "default"),
-                "template"
-            );
+            record.template_name = config.getData().get<std::string>("theme", "default");
+            page_data.set<std::string>(record.template_name, "template");
         } else {
             throw std::runtime_error("No template provided in frontmatter and theme has no default template.");
         }
     }
-    
-    std::time_t timestamp;
-    std::tm tm = {};
-    std::stringstream ss(page_data.get<std::string>("date"));
-    ss >> std::get_time(&tm, "%d-%m-%Y %H:%M");
-    timestamp = mktime(&tm);
-    
+    else if (frontmatter.template_name.has_value()) {
+        record.template_name = frontmatter.template_name.value();
+    }
+    else {
+        throw std::runtime_error("Page template must be a string");
+    }
+
+    std::time_t timestamp = 0;
+    std::optional<utils::DateTime> parsed = utils::parse_date(date);
+    if (parsed.has_value()) {
+        timestamp = utils::to_timestamp(parsed.value(), config.getTimezoneOffset());
+    }
+    else {
+        LOG_WARN("Unrecognized date '" << date << "' in page frontmatter, expected YYYY-MM-DD[THH:MM[:SS][+HH:MM]] or DD-MM-YYYY HH:MM. Defaulting the timestamp to 0");
+    }
+
     page_data.set<std::time_t>(timestamp, "timestamp");
+
+    record.path = page_data.getJsonRef()["path"].get<std::string>();
+    record.timestamp = timestamp;
 }
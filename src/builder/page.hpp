@@ -3,19 +3,41 @@
 
 #include "../data/data.hpp"
 #include "../data/config.hpp"
+#include "frontmatter.hpp"
 #include <string>
 #include <filesystem>
+#include <cstdint>
+#include <vector>
+
+// Where a page came from, kept out of the template data
+struct PageSource {
+    std::filesystem::path path;
+    std::uint64_t hash = 0;             // frontmatter and markdown together
+    std::uint64_t frontmatter_hash = 0;
+    Frontmatter frontmatter;            // as written, before validate() fills in defaults
+};
 
 class Page {
 private:
     Data page_data;
+    PageSource source;
+    PageRecord record;                  // filled by validate()
+    bool rendered = false;
 
 public:
-    Page(const Data& data);
+    Page(Data data, PageSource source = {});
     void validate(Config& config);
     void render(Config& config, const std::string& live_reload_snippet = "");
 
     Data& getPageData() { return page_data; }
+    const PageSource& getSource() const { return source; }
+    const PageRecord& getRecord() const { return record; }
+    void setTagIds(std::vector<TagIndex::Id> ids) { record.tag_ids = std::move(ids); }
+
+    // set once this build's output for the page is in place, whether freshly
+    // rendered or kept from the previous build
+    bool isRendered() const { return rendered; }
+    void setRendered(bool value) { rendered = value; }
     bool operator<(const Page& other) const;
 
     static constexpr const char* DEFAULT_PAGE_TITLE = "Untitled Page";
@@ -0,0 +1,602 @@
+#include <cstdio>
+#include <cstring>
+
+#include <md4c.h>
+
+#include "rendered_markdown.hpp"
+
+extern "C" {
+#include <entity.h>
+}
+
+namespace {
+    constexpr unsigned char NEED_HTML_ESC = 0x1;
+    constexpr unsigned char NEED_URL_ESC = 0x2;
+
+    // which bytes md_html escapes in text and in URLs
+    struct EscapeMap {
+        unsigned char map[256] = {};
+
+        EscapeMap() {
+            for (int i = 0; i < 256; ++i) {
+                char c = static_cast<char>(i);
+                bool alnum = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                // strchr finds the terminator for 0, so NUL is treated as md_html treats it
+                if (std::strchr("\"&<>", c) != nullptr) {
+                    map[i] |= NEED_HTML_ESC;
+                }
+                if (!alnum && std::strchr("~-_.+!*(),%#@?=;:/,+$", c) == nullptr) {
+                    map[i] |= NEED_URL_ESC;
+                }
+            }
+        }
+    };
+
+    const EscapeMap ESCAPES;
+
+    using Append = void (*)(std::string&, const char*, std::size_t);
+
+    void append_verbatim(std::string& out, const char* text, std::size_t size) {
+        out.append(text, size);
+    }
+
+    void append_html_escaped(std::string& out, const char* text, std::size_t size) {
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (!(ESCAPES.map[static_cast<unsigned char>(text[i])] & NEED_HTML_ESC)) {
+                continue;
+            }
+            out.append(text + begin, i - begin);
+            switch (text[i]) {
+                case '&': out += "&amp;"; break;
+                case '<': out += "&lt;"; break;
+                case '>': out += "&gt;"; break;
+                case '"': out += "&quot;"; break;
+            }
+            begin = i + 1;
+        }
+        out.append(text + begin, size - begin);
+    }
+
+    void append_url_escaped(std::string& out, const char* text, std::size_t size) {
+        static constexpr char HEX[] = "0123456789ABCDEF";
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (!(ESCAPES.map[c] & NEED_URL_ESC)) {
+                continue;
+            }
+            out.append(text + begin, i - begin);
+            if (c == '&') {
+                out += "&amp;";
+            }
+            else {
+                char hex[3] = { '%', HEX[(c >> 4) & 0xf], HEX[c & 0xf] };
+                out.append(hex, 3);
+            }
+            begin = i + 1;
+        }
+        out.append(text + begin, size - begin);
+    }
+
+    void append_codepoint(std::string& out, unsigned codepoint, Append append) {
+        static constexpr char REPLACEMENT[] = "\xef\xbf\xbd";
+        if (codepoint == 0 || codepoint > 0x10ffff) {
+            append(out, REPLACEMENT, 3);
+            return;
+        }
+
+        char utf8[4];
+        std::size_t n;
+        if (codepoint <= 0x7f) {
+            n = 1;
+            utf8[0] = static_cast<char>(codepoint);
+        }
+        else if (codepoint <= 0x7ff) {
+            n = 2;
+            utf8[0] = static_cast<char>(0xc0 | ((codepoint >> 6) & 0x1f));
+            utf8[1] = static_cast<char>(0x80 | (codepoint & 0x3f));
+        }
+        else if (codepoint <= 0xffff) {
+            n = 3;
+            utf8[0] = static_cast<char>(0xe0 | ((codepoint >> 12) & 0xf));
+            utf8[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+            utf8[2] = static_cast<char>(0x80 | (codepoint & 0x3f));
+        }
+        else {
+            n = 4;
+            utf8[0] = static_cast<char>(0xf0 | ((codepoint >> 18) & 0x7));
+            utf8[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+            utf8[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+            utf8[3] = static_cast<char>(0x80 | (codepoint & 0x3f));
+        }
+        append(out, utf8, n);
+    }
+
+    unsigned hex_value(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'A' && c <= 'Z') {
+            return c - 'A' + 10;
+        }
+        return c - 'a' + 10;
+    }
+
+    // an entity as the characters it stands for, or as written if it is unknown
+    void append_entity(std::string& out, const char* text, std::size_t size, Append append) {
+        if (size > 3 && text[1] == '#') {
+            unsigned codepoint = 0;
+            if (text[2] == 'x' || text[2] == 'X') {
+                for (std::size_t i = 3; i < size - 1; ++i) {
+                    codepoint = 16 * codepoint + hex_value(text[i]);
+                }
+            }
+            else {
+                for (std::size_t i = 2; i < size - 1; ++i) {
+                    codepoint = 10 * codepoint + (text[i] - '0');
+                }
+            }
+            append_codepoint(out, codepoint, append);
+            return;
+        }
+
+        const ENTITY* entity = entity_lookup(text, size);
+        if (entity != nullptr) {
+            append_codepoint(out, entity->codepoints[0], append);
+            if (entity->codepoints[1]) {
+                append_codepoint(out, entity->codepoints[1], append);
+            }
+            return;
+        }
+        append(out, text, size);
+    }
+
+    void append_attribute(std::string& out, const MD_ATTRIBUTE& attribute, Append append) {
+        for (int i = 0; attribute.substr_offsets[i] < attribute.size; ++i) {
+            MD_OFFSET offset = attribute.substr_offsets[i];
+            MD_SIZE size = attribute.substr_offsets[i + 1] - offset;
+            const char* text = attribute.text + offset;
+
+            switch (attribute.substr_types[i]) {
+                case MD_TEXT_NULLCHAR:  append_codepoint(out, 0, append_verbatim); break;
+                case MD_TEXT_ENTITY:    append_entity(out, text, size, append); break;
+                default:                append(out, text, size); break;
+            }
+        }
+    }
+
+    bool is_word_byte(unsigned char c) {
+        // bytes of multi-byte UTF-8 sequences are taken as letters
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+    }
+
+    // a heading's text as an id: ASCII lowercased, spaces and dashes as single hyphens,
+    // other punctuation dropped and non-ASCII kept as it is
+    std::string heading_slug(const std::string& text) {
+        std::string slug;
+        slug.reserve(text.size());
+        bool pending_hyphen = false;
+        for (unsigned char c : text) {
+            if (is_word_byte(c)) {
+                if (pending_hyphen && !slug.empty()) {
+                    slug.push_back('-');
+                }
+                pending_hyphen = false;
+                slug.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c));
+            }
+            else if (c == ' ' || c == '\t' || c == '\n' || c == '-' || c == '_') {
+                pending_hyphen = true;
+            }
+        }
+        return slug.empty() ? "section" : slug;
+    }
+
+    // whitespace runs as single spaces, without any at either end
+    std::string collapse_space(const std::string& text) {
+        std::string collapsed;
+        collapsed.reserve(text.size());
+        bool pending_space = false;
+        for (char c : text) {
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                pending_space = true;
+                continue;
+            }
+            if (pending_space && !collapsed.empty()) {
+                collapsed.push_back(' ');
+            }
+            pending_space = false;
+            collapsed.push_back(c);
+        }
+        return collapsed;
+    }
+
+    std::string escaped(const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        append_html_escaped(out, text.data(), text.size());
+        return out;
+    }
+
+    // the parser's userdata for one document
+    class Renderer {
+    private:
+        RenderedMarkdown& out;
+        std::string& html;
+
+        int image_nesting = 0;
+        bool in_word = false;
+
+        // text of the heading being rendered, and where its id goes in html
+        bool in_heading = false;
+        std::string heading_text;
+        std::size_t heading_id_position = 0;
+
+        // text of the paragraph that may become the excerpt
+        bool in_excerpt = false;
+        bool excerpt_done = false;
+        std::string excerpt_text;
+
+        void collect(const char* text, std::size_t size) {
+            if (image_nesting > 0) {
+                return;
+            }
+            if (in_heading) {
+                heading_text.append(text, size);
+            }
+            // enough to cut an excerpt from, however long the paragraph
+            if (in_excerpt && excerpt_text.size() < RenderedMarkdown::EXCERPT_LENGTH * 2) {
+                excerpt_text.append(text, size);
+            }
+        }
+
+        void count_words(const char* text, std::size_t size) {
+            if (image_nesting > 0) {
+                return;
+            }
+            for (std::size_t i = 0; i < size; ++i) {
+                if (is_word_byte(static_cast<unsigned char>(text[i]))) {
+                    if (!in_word) {
+                        in_word = true;
+                        ++out.word_count;
+                    }
+                }
+                else {
+                    in_word = false;
+                }
+            }
+        }
+
+        std::string unique_id(const std::string& base) const {
+            std::string id = base;
+            for (std::size_t suffix = 1; ; ++suffix) {
+                bool taken = false;
+                for (const auto& heading : out.toc) {
+                    if (heading.id == id) {
+                        taken = true;
+                        break;
+                    }
+                }
+                if (!taken) {
+                    return id;
+                }
+                id = base + "-" + std::to_string(suffix);
+            }
+        }
+
+        void open_heading() {
+            in_heading = true;
+            heading_text.clear();
+            // just before the closing '>' of the opening tag
+            heading_id_position = html.size() - 1;
+        }
+
+        void close_heading(int level) {
+            in_heading = false;
+            RenderedMarkdown::Heading heading;
+            heading.level = level;
+            heading.id = unique_id(heading_slug(heading_text));
+            heading.title = escaped(collapse_space(heading_text));
+            html.insert(heading_id_position, " id=\"" + heading.id + "\"");
+            out.toc.push_back(std::move(heading));
+        }
+
+        void close_excerpt() {
+            in_excerpt = false;
+            std::string text = collapse_space(excerpt_text);
+            excerpt_text.clear();
+            if (text.empty()) {
+                return;
+            }
+
+            if (text.size() > RenderedMarkdown::EXCERPT_LENGTH) {
+                std::size_t cut = text.rfind(' ', RenderedMarkdown::EXCERPT_LENGTH);
+                if (cut == std::string::npos || cut == 0) {
+                    // one long word; cut where no UTF-8 sequence is split
+                    cut = RenderedMarkdown::EXCERPT_LENGTH;
+                    while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xc0) == 0x80) {
+                        --cut;
+                    }
+                }
+                while (cut > 0 && std::strchr(" ,.;:", text[cut - 1]) != nullptr) {
+                    --cut;
+                }
+                text.resize(cut);
+                text += "\xe2\x80\xa6";
+            }
+            out.excerpt = escaped(text);
+            excerpt_done = true;
+        }
+
+        void open_block(MD_BLOCKTYPE type, void* detail) {
+            static const char* HEAD[6] = { "<h1>", "<h2>", "<h3>", "<h4>", "<h5>", "<h6>" };
+            switch (type) {
+                case MD_BLOCK_DOC:      break;
+                case MD_BLOCK_QUOTE:    html += "<blockquote>\n"; break;
+                case MD_BLOCK_UL:       html += "<ul>\n"; break;
+                case MD_BLOCK_OL: {
+                    const auto* ol = static_cast<const MD_BLOCK_OL_DETAIL*>(detail);
+                    if (ol->start == 1) {
+                        html += "<ol>\n";
+                    }
+                    else {
+                        char buffer[64];
+                        std::snprintf(buffer, sizeof(buffer), "<ol start=\"%u\">\n", ol->start);
+                        html += buffer;
+                    }
+                    break;
+                }
+                case MD_BLOCK_LI: {
+                    const auto* li = static_cast<const MD_BLOCK_LI_DETAIL*>(detail);
+                    if (li->is_task) {
+                        html += "<li class=\"task-list-item\"><input type=\"checkbox\" class=\"task-list-item-checkbox\" disabled";
+                        if (li->task_mark == 'x' || li->task_mark == 'X') {
+                            html += " checked";
+                        }
+                        html += ">";
+                    }
+                    else {
+                        html += "<li>";
+                    }
+                    break;
+                }
+                case MD_BLOCK_HR:       html += "<hr>\n"; break;
+                case MD_BLOCK_H:
+                    html += HEAD[static_cast<const MD_BLOCK_H_DETAIL*>(detail)->level - 1];
+                    open_heading();
+                    break;
+                case MD_BLOCK_CODE: {
+                    const auto* code = static_cast<const MD_BLOCK_CODE_DETAIL*>(detail);
+                    html += "<pre><code";
+                    if (code->lang.text != nullptr) {
+                        html += " class=\"language-";
+                        append_attribute(html, code->lang, append_html_escaped);
+                        html += "\"";
+                    }
+                    html += ">";
+                    break;
+                }
+                case MD_BLOCK_HTML:     break;
+                case MD_BLOCK_P:
+                    html += "<p>";
+                    in_excerpt = !excerpt_done;
+                    break;
+                case MD_BLOCK_TABLE:    html += "<table>\n"; break;
+                case MD_BLOCK_THEAD:    html += "<thead>\n"; break;
+                case MD_BLOCK_TBODY:    html += "<tbody>\n"; break;
+                case MD_BLOCK_TR:       html += "<tr>\n"; break;
+                case MD_BLOCK_TH:
+                case MD_BLOCK_TD: {
+                    html += type == MD_BLOCK_TH ? "<th" : "<td";
+                    switch (static_cast<const MD_BLOCK_TD_DETAIL*>(detail)->align) {
+                        case MD_ALIGN_LEFT:     html += " align=\"left\">"; break;
+                        case MD_ALIGN_CENTER:   html += " align=\"center\">"; break;
+                        case MD_ALIGN_RIGHT:    html += " align=\"right\">"; break;
+                        default:                html += ">"; break;
+                    }
+                    break;
+                }
+            }
+        }
+
+        void close_block(MD_BLOCKTYPE type, void* detail) {
+            static const char* HEAD[6] = { "</h1>\n", "</h2>\n", "</h3>\n", "</h4>\n", "</h5>\n", "</h6>\n" };
+            switch (type) {
+                case MD_BLOCK_DOC:      break;
+                case MD_BLOCK_QUOTE:    html += "</blockquote>\n"; break;
+                case MD_BLOCK_UL:       html += "</ul>\n"; break;
+                case MD_BLOCK_OL:       html += "</ol>\n"; break;
+                case MD_BLOCK_LI:       html += "</li>\n"; break;
+                case MD_BLOCK_HR:       break;
+                case MD_BLOCK_H: {
+                    int level = static_cast<const MD_BLOCK_H_DETAIL*>(detail)->level;
+                    close_heading(level);
+                    html += HEAD[level - 1];
+                    break;
+                }
+                case MD_BLOCK_CODE:     html += "</code></pre>\n"; break;
+                case MD_BLOCK_HTML:     break;
+                case MD_BLOCK_P:
+                    html += "</p>\n";
+                    if (in_excerpt) {
+                        close_excerpt();
+                    }
+                    break;
+                case MD_BLOCK_TABLE:    html += "</table>\n"; break;
+                case MD_BLOCK_THEAD:    html += "</thead>\n"; break;
+                case MD_BLOCK_TBODY:    html += "</tbody>\n"; break;
+                case MD_BLOCK_TR:       html += "</tr>\n"; break;
+                case MD_BLOCK_TH:       html += "</th>\n"; break;
+                case MD_BLOCK_TD:       html += "</td>\n"; break;
+            }
+        }
+
+        void open_span(MD_SPANTYPE type, void* detail) {
+            // inside an image only the alt text is written, so nested markup is dropped
+            bool inside_image = image_nesting > 0;
+            if (type == MD_SPAN_IMG) {
+                ++image_nesting;
+            }
+            if (inside_image) {
+                return;
+            }
+
+            switch (type) {
+                case MD_SPAN_EM:                html += "<em>"; break;
+                case MD_SPAN_STRONG:            html += "<strong>"; break;
+                case MD_SPAN_U:                 html += "<u>"; break;
+                case MD_SPAN_A: {
+                    const auto* a = static_cast<const MD_SPAN_A_DETAIL*>(detail);
+                    html += "<a href=\"";
+                    append_attribute(html, a->href, append_url_escaped);
+                    if (a->title.text != nullptr) {
+                        html += "\" title=\"";
+                        append_attribute(html, a->title, append_html_escaped);
+                    }
+                    html += "\">";
+                    break;
+                }
+                case MD_SPAN_IMG:
+                    html += "<img src=\"";
+                    append_attribute(html, static_cast<const MD_SPAN_IMG_DETAIL*>(detail)->src, append_url_escaped);
+                    html += "\" alt=\"";
+                    break;
+                case MD_SPAN_CODE:              html += "<code>"; break;
+                case MD_SPAN_DEL:               html += "<del>"; break;
+                case MD_SPAN_LATEXMATH:         html += "<x-equation>"; break;
+                case MD_SPAN_LATEXMATH_DISPLAY: html += "<x-equation type=\"display\">"; break;
+                case MD_SPAN_WIKILINK:
+                    html += "<x-wikilink data-target=\"";
+                    append_attribute(html, static_cast<const MD_SPAN_WIKILINK_DETAIL*>(detail)->target, append_html_escaped);
+                    html += "\">";
+                    break;
+            }
+        }
+
+        void close_span(MD_SPANTYPE type, void* detail) {
+            if (type == MD_SPAN_IMG) {
+                --image_nesting;
+            }
+            if (image_nesting > 0) {
+                return;
+            }
+
+            switch (type) {
+                case MD_SPAN_EM:                html += "</em>"; break;
+                case MD_SPAN_STRONG:            html += "</strong>"; break;
+                case MD_SPAN_U:                 html += "</u>"; break;
+                case MD_SPAN_A:                 html += "</a>"; break;
+                case MD_SPAN_IMG: {
+                    const auto* img = static_cast<const MD_SPAN_IMG_DETAIL*>(detail);
+                    if (img->title.text != nullptr) {
+                        html += "\" title=\"";
+                        append_attribute(html, img->title, append_html_escaped);
+                    }
+                    html += "\">";
+                    break;
+                }
+                case MD_SPAN_CODE:              html += "</code>"; break;
+                case MD_SPAN_DEL:               html += "</del>"; break;
+                case MD_SPAN_LATEXMATH:
+                case MD_SPAN_LATEXMATH_DISPLAY: html += "</x-equation>"; break;
+                case MD_SPAN_WIKILINK:          html += "</x-wikilink>"; break;
+            }
+        }
+
+        void text(MD_TEXTTYPE type, const char* text, std::size_t size) {
+            switch (type) {
+                case MD_TEXT_NULLCHAR:
+                    append_codepoint(html, 0, append_verbatim);
+                    in_word = false;
+                    break;
+                case MD_TEXT_BR:
+                    html += image_nesting == 0 ? "<br>\n" : " ";
+                    collect(" ", 1);
+                    in_word = false;
+                    break;
+                case MD_TEXT_SOFTBR:
+                    html += image_nesting == 0 ? "\n" : " ";
+                    collect(" ", 1);
+                    in_word = false;
+                    break;
+                case MD_TEXT_HTML:
+                    html.append(text, size);
+                    break;
+                case MD_TEXT_ENTITY: {
+                    append_entity(html, text, size, append_html_escaped);
+                    if (in_heading || in_excerpt) {
+                        std::string decoded;
+                        append_entity(decoded, text, size, append_verbatim);
+                        collect(decoded.data(), decoded.size());
+                    }
+                    in_word = false;
+                    break;
+                }
+                default:
+                    append_html_escaped(html, text, size);
+                    collect(text, size);
+                    count_words(text, size);
+                    break;
+            }
+        }
+
+    public:
+        explicit Renderer(RenderedMarkdown& out) :
+            out(out),
+            html(out.html)
+        {}
+
+        static int enterBlock(MD_BLOCKTYPE type, void* detail, void* userdata) {
+            Renderer* renderer = static_cast<Renderer*>(userdata);
+            renderer->in_word = false;
+            renderer->open_block(type, detail);
+            return 0;
+        }
+
+        static int leaveBlock(MD_BLOCKTYPE type, void* detail, void* userdata) {
+            Renderer* renderer = static_cast<Renderer*>(userdata);
+            renderer->in_word = false;
+            renderer->close_block(type, detail);
+            return 0;
+        }
+
+        static int enterSpan(MD_SPANTYPE type, void* detail, void* userdata) {
+            static_cast<Renderer*>(userdata)->open_span(type, detail);
+            return 0;
+        }
+
+        static int leaveSpan(MD_SPANTYPE type, void* detail, void* userdata) {
+            static_cast<Renderer*>(userdata)->close_span(type, detail);
+            return 0;
+        }
+
+        static int onText(MD_TEXTTYPE type, const MD_CHAR* text, MD_SIZE size, void* userdata) {
+            static_cast<Renderer*>(userdata)->text(type, text, size);
+            return 0;
+        }
+    };
+}
+
+RenderedMarkdown::RenderedMarkdown(std::string_view markdown, unsigned parser_flags) {
+    // md4c emits many small fragments; sizing for the typical markup overhead up
+    // front keeps most pages at a single allocation
+    html.reserve(markdown.size() + markdown.size() / 2);
+
+    Renderer renderer(*this);
+    MD_PARSER parser = {
+        0,
+        parser_flags,
+        Renderer::enterBlock,
+        Renderer::leaveBlock,
+        Renderer::enterSpan,
+        Renderer::leaveSpan,
+        Renderer::onText,
+        nullptr,
+        nullptr
+    };
+    md_parse(markdown.data(), static_cast<MD_SIZE>(markdown.size()), &parser, &renderer);
+}
+
+std::size_t RenderedMarkdown::readingTime() const {
+    return (word_count + WORDS_PER_MINUTE - 1) / WORDS_PER_MINUTE;
+}
@@ -0,0 +1,38 @@
+#ifndef RENDERED_MARKDOWN_HPP_
+#define RENDERED_MARKDOWN_HPP_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../utils/debug.hpp"
+
+// A page's markdown after a single md4c pass. The HTML is written from md4c's block,
+// span and text callbacks as md_html would write it, apart from an id on every heading,
+// and the same callbacks count the words of the text and pick out the excerpt and the
+// headings, so nothing has to go back over the markdown or the HTML afterwards.
+class RenderedMarkdown {
+public:
+    struct Heading {
+        int level = 1;
+        std::string id;                 // unique within the page
+        std::string title;              // text only, escaped for HTML
+    };
+
+    std::string html;
+    std::size_t word_count = 0;         // words of the text, not of the markup around it
+    std::string excerpt;                // first paragraph with text, escaped for HTML
+    std::vector<Heading> toc;           // every heading, in document order
+
+    RenderedMarkdown() = default;
+    RenderedMarkdown(std::string_view markdown, unsigned parser_flags);
+
+    // minutes at WORDS_PER_MINUTE, rounded up
+    std::size_t readingTime() const;
+
+    static constexpr std::size_t WORDS_PER_MINUTE = 200;
+    // longer excerpts are cut at the last space before this many bytes
+    static constexpr std::size_t EXCERPT_LENGTH = 200;
+};
+
+#endif
@@ -1,11 +1,15 @@
+#include <mutex>
 #include "config.hpp"
 #include "../utils/utils.hpp"
+#include "../utils/date.hpp"
 #include "../utils/logger.hpp"
+#include "../utils/string_output.hpp"
 
-Config::Config(const std::filesystem::path& path) : 
+Config::Config(const std::filesystem::path& path, ThreadPool& pool, MemoryFiles* memory_output) : 
     site_dir    (siteDirFactory(path)),
     data        (dataFactory(path)),
-    theme_dir   (themeDirFactory())
+    theme_dir   (themeDirFactory()),
+    output      (getOutputDirectory(), memory_output)
 {
     try {
         std::ifstream fs(theme_dir / "config.json");
@@ -20,6 +24,9 @@ Config::Config(const std::filesystem::path& path) :
         ss << "Error validating config.json: " << e.what() << std::endl;
         throw std::runtime_error(ss.str());
     }
+
+    compile_templates(pool);
+    collect_frontmatter_keys();
 }
 
 std::filesystem::path Config::siteDirFactory(const std::filesystem::path& path) {
@@ -75,6 +82,16 @@ void Config::validate_site_config() {
     if (!data.hasKey("site", "description")) {
         data.set<std::string>(DEFAULT_SITE_DESCRIPTION, "site", "description");
     }
+
+    if (data.hasKey("site", "timezone")) {
+        std::string timezone = data.get<std::string>("site", "timezone");
+        if (timezone != "local") {
+            timezone_offset = utils::parse_utc_offset(timezone);
+            if (!timezone_offset.has_value()) {
+                throw std::runtime_error("Invalid timezone '" + timezone + "' in site config.json, expected local, UTC or an offset such as +02:00");
+            }
+        }
+    }
 }
 
 void Config::validate_theme_config() {
@@ -91,14 +108,77 @@ void Config::validate_theme_config() {
     }
 }
 
-const inja::Template& Config::getTemplate(const std::string& template_name) {
-    static std::mutex template_mutex;
-    std::lock_guard<std::mutex> lock(template_mutex);
+void Config::compile_templates(ThreadPool& pool) {
+    std::vector<std::string> template_names;
+    for (const auto& [template_name, _] : data.getJsonRef()["theme"]["templates"].items()) {
+        template_names.push_back(template_name);
+        templates[template_name] = nullptr;
+    }
+
+    bool compile_programs = false;
+    if (data.hasKey("site", "compile_templates")) {
+        compile_programs = data.get<bool>("site", "compile_templates");
+    }
+
+    // inja parses includes into the storage of the environment doing the parsing,
+    // so each template gets its own copy and the storages are merged afterwards
+    const inja::Environment base_env = env;
+    std::mutex merge_mutex;
+    utils::parallel_for(pool, template_names.size(), [this, &template_names, &base_env, &merge_mutex, compile_programs](std::size_t idx) {
+        inja::Environment template_env = base_env;
+        std::unique_ptr<CompiledTemplate> compiled = compile_template(template_names[idx], template_env, compile_programs);
+
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        for (const auto& [name, included] : template_env.get_template_storage()) {
+            if (env.get_template_storage().find(name) == env.get_template_storage().end()) {
+                env.include_template(name, included);
+            }
+        }
+        templates[template_names[idx]] = std::move(compiled);
+    }, 1);
+
+    for (const auto& template_name : template_names) {
+        if (!templates[template_name]->error.empty()) {
+            // reported again when a page uses it
+            LOG_WARN(templates[template_name]->error);
+        }
+    }
+}
 
-    if (template_map.find(template_name) != template_map.end()) {
-        return template_map[template_name];
+void Config::collect_frontmatter_keys() {
+    if (!data.hasKey("site", "lazy_frontmatter") || !data.get<bool>("site", "lazy_frontmatter")) {
+        return;
     }
 
+    std::set<std::string> keys;
+    for (const auto& [template_name, compiled] : templates) {
+        if (!compiled->error.empty()) {
+            // never renders, so reads nothing
+            continue;
+        }
+
+        const TemplateDependencies& dependencies = compiled->dependencies;
+        if (dependencies.dynamic || dependencies.all_fields || dependencies.variables.count("page")) {
+            LOG_INFO("Template '" << template_name << "' may read any page field; keeping all frontmatter");
+            return;
+        }
+        keys.insert(dependencies.fields.begin(), dependencies.fields.end());
+    }
+    frontmatter_keys = std::move(keys);
+}
+
+bool Config::templatesReadField(const std::string& field, const std::set<std::string>& bound) const {
+    for (const auto& [template_name, compiled] : templates) {
+        if (compiled->error.empty() && compiled->dependencies.readsFieldOutside(field, bound)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<Config::CompiledTemplate> Config::compile_template(const std::string& template_name, inja::Environment& template_env, bool compile_program) const {
+    auto compiled = std::make_unique<CompiledTemplate>();
+
     try {
         std::filesystem::path template_path = theme_dir / data.get<std::string>("theme", "templates", template_name);
 
@@ -108,14 +188,95 @@ const inja::Template& Config::getTemplate(const std::string& template_name) {
             throw std::runtime_error(ss.str());
         }
 
-        template_map[template_name] = env.parse_template(template_path.string());
+        compiled->temp = template_env.parse_template(template_path.string());
+        compiled->dependencies = analyse_template(compiled->temp, template_env.get_template_storage());
+
+        // the include graph comes from the parsed include and extends statements,
+        // whose names inja resolves to the files it read
+        std::set<std::filesystem::path> files;
+        files.insert(template_path.lexically_normal());
+        for (const auto& file : compiled->dependencies.templates) {
+            files.insert(std::filesystem::path(file).lexically_normal());
+        }
+
+        std::uint64_t template_hash = utils::HASH_SEED;
+        std::string content;
+        for (const auto& file : files) {
+            if (!utils::read_file(file, content)) {
+                throw std::runtime_error("Failed to read template file: " + file.string());
+            }
+            template_hash = utils::hash(file.lexically_relative(theme_dir.lexically_normal()).generic_string(), template_hash);
+            template_hash = utils::hash(utils::to_hex(utils::hash(content)), template_hash);
+        }
+        compiled->hash = utils::to_hex(template_hash);
+
+        if (compile_program) {
+            std::string reason;
+            compiled->program = TemplateProgram::compile(compiled->temp, template_env.get_template_storage(), &reason);
+            if (!compiled->program) {
+                LOG_INFO("Template '" << template_name << "' is rendered by inja: " << reason);
+            }
+        }
     } catch (const std::exception& e) {
         std::stringstream ss;
         ss << "Error while retrieving template '" << template_name << "': " << e.what() << std::endl;
+
+        compiled = std::make_unique<CompiledTemplate>();
+        compiled->error = ss.str();
+    }
+
+    return compiled;
+}
+
+const Config::CompiledTemplate& Config::findTemplate(const std::string& template_name) const {
+    auto it = templates.find(template_name);
+    if (it == templates.end()) {
+        std::stringstream ss;
+        ss << "Error while retrieving template '" << template_name << "': not listed in the theme configuration" << std::endl;
         throw std::runtime_error(ss.str());
     }
 
-    return template_map[template_name];
+    if (!it->second->error.empty()) {
+        throw std::runtime_error(it->second->error);
+    }
+    return *it->second;
+}
+
+const TemplateDependencies& Config::getTemplateDependencies(const std::string& template_name) const {
+    return findTemplate(template_name).dependencies;
+}
+
+const std::string& Config::getTemplateHash(const std::string& template_name) const {
+    return findTemplate(template_name).hash;
+}
+
+void Config::render_to(const std::string& template_name, const nlohmann::json& render_data, const inja::DataLayer* layer, std::string& out) {
+    const CompiledTemplate& compiled = findTemplate(template_name);
+    compiled.requested.store(true, std::memory_order_relaxed);
+
+    out.clear();
+    if (compiled.program) {
+        compiled.program->render_to(out, render_data, layer);
+        return;
+    }
+
+    StringOutput stream(out);
+    if (layer) {
+        env.render_to(stream, compiled.temp, render_data, *layer);
+    }
+    else {
+        env.render_to(stream, compiled.temp, render_data);
+    }
+}
+
+std::set<std::string> Config::takeRequestedTemplates() {
+    std::set<std::string> requested;
+    for (const auto& [template_name, compiled] : templates) {
+        if (compiled->requested.exchange(false, std::memory_order_relaxed)) {
+            requested.insert(template_name);
+        }
+    }
+    return requested;
 }
 
 std::vector<nlohmann::json> Config::get_directives()
@@ -1,41 +1,100 @@
 #ifndef CONFIG_HPP_
 #define CONFIG_HPP_
 
+#include <atomic>
 #include <filesystem>
 #include <inja.hpp>
-#include <mutex>
+#include <memory>
+#include <optional>
+#include <set>
+#include <unordered_map>
 #include "data.hpp"
+#include "page_store.hpp"
+#include "tag_index.hpp"
+#include "template_analysis.hpp"
+#include "template_program.hpp"
+#include "../utils/output.hpp"
+#include "../utils/thread_pool.hpp"
 #include "../utils/debug.hpp"
 
 
 class Config {
+public:
+    // a theme template, parsed while the config is loaded and never modified afterwards
+    struct CompiledTemplate {
+        inja::Template temp;
+        TemplateDependencies dependencies;
+        std::string hash;       // the template file and every file it includes or extends
+        std::string error;      // why it failed to load, in which case the rest is empty
+        std::unique_ptr<const TemplateProgram> program;     // null when rendered by inja
+        mutable std::atomic<bool> requested{ false };
+    };
+
 private:
     inja::Environment env;
-    std::map<std::string, inja::Template> template_map;
+    // every template in the theme's templates map; filled by the constructor and
+    // read without locking afterwards
+    std::unordered_map<std::string, std::unique_ptr<const CompiledTemplate>> templates;
 
     // initialization list order
     std::filesystem::path site_dir;
     Data data;
     std::filesystem::path theme_dir;
+    Output output;
+    PageStore page_store;
+    TagIndex tag_index;
+    std::optional<int> timezone_offset;     // minutes east of UTC; local time when unset
+    // names the templates may read, which is all a page's frontmatter needs to keep;
+    // unset when every key is kept
+    std::optional<std::set<std::string>> frontmatter_keys;
 
     std::filesystem::path   siteDirFactory(const std::filesystem::path& path);
     std::filesystem::path   themeDirFactory() const;
     Data                    dataFactory(const std::filesystem::path& path);
 
+    void                                compile_templates(ThreadPool& pool);
+    void                                collect_frontmatter_keys();
+    std::unique_ptr<CompiledTemplate>   compile_template(const std::string& template_name, inja::Environment& template_env, bool compile_program) const;
+    // throws if the template is unknown or failed to load
+    const CompiledTemplate&             findTemplate(const std::string& template_name) const;
+
 public:
-    Config(const std::filesystem::path& config_path);
+    // outputs go to memory_output instead of the output directory when one is given
+    // the theme's templates are parsed on pool before the constructor returns
+    Config(const std::filesystem::path& config_path, ThreadPool& pool, MemoryFiles* memory_output = nullptr);
     void validate_theme_config();
     void validate_site_config();
 
     inja::Environment&              getEnvironment() { return env; }
-    const inja::Template&           getTemplate(const std::string& template_name);
+    const TemplateDependencies&     getTemplateDependencies(const std::string& template_name) const;
+    // covers the template file and every file it includes or extends, directly or not
+    const std::string&              getTemplateHash(const std::string& template_name) const;
+    // replaces the contents of out, keeping its capacity; uses the compiled program
+    // when there is one, inja otherwise. Counts as a request for the template.
+    void                            render_to(const std::string& template_name, const nlohmann::json& render_data, const inja::DataLayer* layer, std::string& out);
+    // names passed to render_to since the last call
+    std::set<std::string>           takeRequestedTemplates();
     
     const std::filesystem::path&    getSiteDirectory() const { return site_dir; }
     const std::filesystem::path&    getThemeDirectory() const { return theme_dir; }
+    std::filesystem::path           getOutputDirectory() const { return site_dir / "output"; }
+    // state kept between builds (manifest, caches)
+    std::filesystem::path           getStateDirectory() const { return site_dir / STATE_DIRECTORY; }
+    Output&                         getOutput() { return output; }
     Data&                           getData() { return data; }
+    PageStore&                      getPageStore() { return page_store; }
+    TagIndex&                       getTagIndex() { return tag_index; }
+    // what dates without an offset of their own are read in; the site's timezone key
+    std::optional<int>              getTimezoneOffset() const { return timezone_offset; }
+    // true when some template that loaded may read field below anything but the
+    // names in bound; see TemplateDependencies::readsFieldOutside
+    bool                            templatesReadField(const std::string& field, const std::set<std::string>& bound) const;
+    // null when pages keep every frontmatter key
+    const std::set<std::string>*    getFrontmatterKeys() const { return frontmatter_keys ? &frontmatter_keys.value() : nullptr; }
     std::vector<nlohmann::json>     get_directives();
 
     static constexpr const char* DEFAULT_SITE_TITLE = "Site";
     static constexpr const char* DEFAULT_SITE_DESCRIPTION = "Very cool website.";
+    static constexpr const char* STATE_DIRECTORY = ".simple-sg";
 };
 #endif
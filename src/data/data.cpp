@@ -25,6 +25,16 @@ Data::Data(const std::string& str) {
     }
 }
 
+Data::Data(std::string_view str) {
+    try {
+        data = nlohmann::json::parse(str);
+    } catch (const std::exception& e) {
+        std::stringstream ss;
+        ss << "Error parsing JSON string: " << e.what();
+        throw std::runtime_error(ss.str());
+    }
+}
+
 Data::Data(const std::string& key, std::ifstream& fs) {
     try {
         data[key] = nlohmann::json::parse(fs);
@@ -14,6 +14,7 @@ public:
     Data(std::ifstream& fs);
     Data(const std::string& str, std::ifstream& fs);
     Data(const std::string& data);
+    Data(std::string_view data);
     Data(const nlohmann::json& data);
 
     template<typename T, typename... Keys>
@@ -24,7 +25,7 @@ public:
             if constexpr (std::is_same_v<T, Data>) {
                 *current = value.getJson();
             } else {
-                *current = value;
+                *current = std::move(value);
             }
         } catch (const nlohmann::json::exception& e) {
             std::stringstream ss;
@@ -100,6 +101,11 @@ public:
     nlohmann::json getJson() const {
         return data;
     }
+
+    // read-only access without copying, for data that is shared between threads
+    const nlohmann::json& getJsonRef() const {
+        return data;
+    }
 };
 
 #endif
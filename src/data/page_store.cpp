@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <numeric>
+
+#include "page_store.hpp"
+
+void PageStore::reserve(std::size_t count) {
+    timestamps.reserve(count);
+    indexable.reserve(count);
+}
+
+void PageStore::add(const PageRecord& record) {
+    timestamps.push_back(record.timestamp);
+    indexable.push_back(record.indexable ? 1 : 0);
+}
+
+std::vector<std::size_t> PageStore::sort() {
+    std::vector<std::size_t> positions(timestamps.size());
+    std::iota(positions.begin(), positions.end(), std::size_t{ 0 });
+    std::stable_sort(positions.begin(), positions.end(), [this](std::size_t a, std::size_t b) {
+        return timestamps[a] > timestamps[b];
+    });
+
+    std::vector<std::time_t> sorted_timestamps;
+    std::vector<char> sorted_indexable;
+    sorted_timestamps.reserve(positions.size());
+    sorted_indexable.reserve(positions.size());
+    for (std::size_t position : positions) {
+        sorted_timestamps.push_back(timestamps[position]);
+        sorted_indexable.push_back(indexable[position]);
+    }
+    timestamps.swap(sorted_timestamps);
+    indexable.swap(sorted_indexable);
+    return positions;
+}
+
+std::vector<std::size_t> PageStore::indexablePositions() const {
+    std::vector<std::size_t> positions;
+    for (std::size_t position = 0; position < indexable.size(); ++position) {
+        if (indexable[position]) {
+            positions.push_back(position);
+        }
+    }
+    return positions;
+}
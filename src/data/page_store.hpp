@@ -0,0 +1,48 @@
+#ifndef PAGE_STORE_HPP_
+#define PAGE_STORE_HPP_
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "tag_index.hpp"
+#include "../utils/debug.hpp"
+
+// The fields of a page the builder and the directives work with, typed once when
+// the page is validated instead of looked up by key in its JSON every time
+struct PageRecord {
+    std::string template_name;
+    std::string path;
+    std::time_t timestamp = 0;
+    bool indexable = false;
+    std::vector<TagIndex::Id> tag_ids;  // one per entry of the tags array
+};
+
+// Every page of the site in site order (newest first) once sorted, one column per field.
+// Sorting and filtering run on the columns; the JSON of each page, which is what
+// templates see, is only reached through view() once a page is picked.
+class PageStore {
+private:
+    std::vector<std::time_t> timestamps;
+    std::vector<char> indexable;
+    const nlohmann::json* views = nullptr;  // site.pages
+
+public:
+    void reserve(std::size_t count);
+    // appends the page at the next position
+    void add(const PageRecord& record);
+    // puts the pages in site order, newest first with ties kept in the order they were
+    // added; returns the position each page was added at, in the new order
+    std::vector<std::size_t> sort();
+    // pages must hold the JSON of every page added, in the same order, and outlive the store's readers
+    void attach(const nlohmann::json& pages) { views = &pages; }
+
+    std::size_t     size() const { return timestamps.size(); }
+    bool            empty() const { return timestamps.empty(); }
+    const nlohmann::json& view(std::size_t position) const { return (*views)[position]; }
+
+    // positions of the pages that go into the site index
+    std::vector<std::size_t> indexablePositions() const;
+};
+
+#endif
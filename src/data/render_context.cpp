@@ -0,0 +1,27 @@
+#include "render_context.hpp"
+
+RenderContext::RenderContext(const Data& site_data) :
+    site(site_data.getJsonRef())
+{
+}
+
+RenderContext& RenderContext::bind(const std::string& key, const nlohmann::json& value) {
+    for (auto& [bound_key, bound_value] : layer) {
+        if (bound_key == key) {
+            bound_value = &value;
+            return *this;
+        }
+    }
+
+    layer.emplace_back(key, &value);
+    return *this;
+}
+
+RenderContext& RenderContext::extend(const std::string& key, const nlohmann::json& value) {
+    layer.emplace_back(key, &value);
+    return *this;
+}
+
+void RenderContext::render_to(Config& config, const std::string& template_name, std::string& out) const {
+    config.render_to(template_name, site, &layer, out);
+}
@@ -0,0 +1,31 @@
+#ifndef RENDER_CONTEXT_HPP_
+#define RENDER_CONTEXT_HPP_
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include <inja.hpp>
+#include "config.hpp"
+#include "data.hpp"
+#include "../utils/debug.hpp"
+
+// Read-only view handed to templates: per-render values (page, index, ...) are
+// layered over the shared site data, so neither side is copied for a render.
+// The site data must not be modified while a context referring to it is alive.
+class RenderContext {
+private:
+    const nlohmann::json& site;
+    inja::DataLayer layer;
+
+public:
+    explicit RenderContext(const Data& site_data);
+
+    // binds a top-level template name to value; value must outlive the context
+    RenderContext& bind(const std::string& key, const nlohmann::json& value);
+    // names under key missing from what is bound to it are looked up in value instead
+    RenderContext& extend(const std::string& key, const nlohmann::json& value);
+
+    // replaces the contents of out, keeping its capacity
+    void render_to(Config& config, const std::string& template_name, std::string& out) const;
+};
+
+#endif
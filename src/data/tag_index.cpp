@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cctype>
+
+#include "tag_index.hpp"
+
+TagIndex::Id TagIndex::intern(const std::string& name) {
+    std::string slug = slugify(name);
+
+    std::lock_guard<std::mutex> lock(intern_mutex);
+    auto [it, inserted] = ids.try_emplace(slug, static_cast<Id>(tags.size()));
+    if (inserted) {
+        tags.push_back({ name, std::move(slug), {} });
+    }
+    return it->second;
+}
+
+void TagIndex::add(std::size_t position, const std::vector<Id>& tag_ids, const nlohmann::json& tag_names) {
+    for (std::size_t i = 0; i < tag_ids.size(); ++i) {
+        Tag& tag = tags[tag_ids[i]];
+        if (tag.pages.empty()) {
+            tag.name = tag_names[i].get<std::string>();
+        }
+        // two spellings of the same tag on one page count once
+        if (tag.pages.empty() || tag.pages.back() != position) {
+            tag.pages.push_back(position);
+        }
+    }
+}
+
+void TagIndex::finish() {
+    by_name.clear();
+    for (Id id = 0; id < tags.size(); ++id) {
+        if (!tags[id].pages.empty()) {
+            by_name.push_back(id);
+        }
+    }
+
+    std::sort(by_name.begin(), by_name.end(), [this](Id a, Id b) {
+        return tags[a].name < tags[b].name;
+    });
+
+    nlohmann::json all_tags = nlohmann::json::array();
+    for (Id id : by_name) {
+        all_tags.push_back({
+            { "name", tags[id].name },
+            { "slug", tags[id].slug },
+            { "count", tags[id].pages.size() }
+        });
+    }
+    page_fields["all_tags"] = std::move(all_tags);
+}
+
+std::string TagIndex::slugify(const std::string& value) {
+    std::string slug;
+    slug.reserve(value.size());
+
+    bool last_was_hyphen = false;
+    for (unsigned char c : value) {
+        if (std::isalnum(c)) {
+            slug.push_back(static_cast<char>(std::tolower(c)));
+            last_was_hyphen = false;
+        }
+        else if (std::isspace(c) || c == '-' || c == '_' || c == '/') {
+            if (!last_was_hyphen && !slug.empty()) {
+                slug.push_back('-');
+                last_was_hyphen = true;
+            }
+        }
+    }
+
+    while (!slug.empty() && slug.back() == '-') {
+        slug.pop_back();
+    }
+
+    if (slug.empty()) {
+        slug = "tag";
+    }
+
+    return slug;
+}
@@ -0,0 +1,54 @@
+#ifndef TAG_INDEX_HPP_
+#define TAG_INDEX_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../utils/debug.hpp"
+
+// Every tag of the site, interned to a small id by its slug. Content threads intern
+// the tags of their pages as they go; once the pages are in site order each tag gets
+// a posting list of positions in site.pages. Tag archives are rendered from those
+// positions, so a page is referenced once per tag it carries instead of copied.
+class TagIndex {
+public:
+    using Id = std::uint32_t;
+
+    struct Tag {
+        std::string name;                   // as written on the newest page carrying it
+        std::string slug;
+        std::vector<std::size_t> pages;     // positions in site.pages, newest first
+    };
+
+private:
+    std::mutex intern_mutex;
+    std::unordered_map<std::string, Id> ids;    // by slug
+    std::vector<Tag> tags;
+    std::vector<Id> by_name;
+    // {"all_tags": [...]}, looked up under page for names the page itself lacks
+    nlohmann::json page_fields = { { "all_tags", nlohmann::json::array() } };
+
+public:
+    // safe to call from several threads; names with the same slug share an id
+    Id intern(const std::string& name);
+
+    // the page at position in site.pages carries tag_ids, interned from tag_names in
+    // the same order; positions are added in increasing order from one thread
+    void add(std::size_t position, const std::vector<Id>& tag_ids, const nlohmann::json& tag_names);
+    // orders the tags by name; called once every page is added
+    void finish();
+
+    const Tag&                  get(Id id) const { return tags[id]; }
+    // tags carried by at least one page, by name
+    const std::vector<Id>&      byName() const { return by_name; }
+    // {name, slug, count} for each tag, by name
+    const nlohmann::json&       summary() const { return page_fields["all_tags"]; }
+    const nlohmann::json&       pageFields() const { return page_fields; }
+
+    static std::string slugify(const std::string& value);
+};
+
+#endif
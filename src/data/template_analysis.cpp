@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <vector>
+#include "template_analysis.hpp"
+
+namespace {
+    class DependencyVisitor : public inja::NodeVisitor {
+    private:
+        const inja::TemplateStorage& storage;
+        std::set<const inja::Template*> visited;
+        // names bound by enclosing for loops and earlier set statements; a set key
+        // stays dotted, as {% set page.x = ... %} leaves the rest of page to the data
+        std::vector<std::string> locals;
+
+        // true if name is a local or lies below one
+        bool isLocal(const std::string& name) const {
+            for (const auto& local : locals) {
+                if (name.compare(0, local.size(), local) == 0 && (name.size() == local.size() || name[local.size()] == '.')) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void addFields(const std::string& name) {
+            for (std::size_t start = 0; start <= name.size();) {
+                std::size_t end = std::min(name.find('.', start), name.size());
+                dependencies.fields.insert(name.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+
+        void addVariable(const std::string& name) {
+            addFields(name);
+            if (!isLocal(name)) {
+                dependencies.variables.insert(name);
+            }
+            else {
+                dependencies.local_variables.insert(name);
+            }
+        }
+
+        void visitTemplate(const std::string& name) {
+            dependencies.templates.insert(name);
+            auto it = storage.find(name);
+            if (it == storage.end()) {
+                // unresolved at parse time; rendering will fail on it anyway
+                return;
+            }
+            visit(it->second);
+        }
+
+    public:
+        TemplateDependencies dependencies;
+
+        explicit DependencyVisitor(const inja::TemplateStorage& storage) : storage(storage) { }
+
+        void visit(const inja::Template& temp) {
+            if (!visited.insert(&temp).second) {
+                return;
+            }
+
+            // included templates start without the caller's set variables
+            std::vector<std::string> saved_locals;
+            saved_locals.swap(locals);
+            temp.root.accept(*this);
+            locals.swap(saved_locals);
+        }
+
+        void visit(const inja::BlockNode& node) override {
+            for (const auto& n : node.nodes) {
+                n->accept(*this);
+            }
+        }
+
+        void visit(const inja::TextNode&) override { }
+        void visit(const inja::ExpressionNode&) override { }
+        void visit(const inja::LiteralNode&) override { }
+
+        void visit(const inja::DataNode& node) override {
+            addVariable(node.name);
+        }
+
+        void visit(const inja::FunctionNode& node) override {
+            using Op = inja::FunctionStorage::Operation;
+
+            if (node.operation == Op::Exists) {
+                auto* literal = node.arguments.empty() ? nullptr : dynamic_cast<const inja::LiteralNode*>(node.arguments[0].get());
+                if (literal && literal->value.is_string()) {
+                    addVariable(literal->value.get<std::string>());
+                } else {
+                    dependencies.dynamic = true;
+                }
+            }
+
+            if (node.operation == Op::At || node.operation == Op::ExistsInObject) {
+                auto* literal = node.arguments.size() < 2 ? nullptr : dynamic_cast<const inja::LiteralNode*>(node.arguments[1].get());
+                if (literal && literal->value.is_string()) {
+                    dependencies.fields.insert(literal->value.get<std::string>());
+                } else if (!literal) {
+                    dependencies.all_fields = true;
+                }
+            }
+
+            if (node.operation == Op::Callback) {
+                // callbacks can read anything; a no-argument one is also parsed as a DataNode
+                dependencies.dynamic = true;
+            }
+
+            for (const auto& n : node.arguments) {
+                n->accept(*this);
+            }
+        }
+
+        void visit(const inja::ExpressionListNode& node) override {
+            if (node.root) {
+                node.root->accept(*this);
+            }
+        }
+
+        void visit(const inja::StatementNode&) override { }
+        void visit(const inja::ForStatementNode&) override { }
+
+        void visit(const inja::ForArrayStatementNode& node) override {
+            node.condition.accept(*this);
+            locals.push_back(node.value);
+            locals.push_back("loop");
+            node.body.accept(*this);
+            locals.pop_back();
+            locals.pop_back();
+        }
+
+        void visit(const inja::ForObjectStatementNode& node) override {
+            dependencies.all_fields = true;
+            node.condition.accept(*this);
+            locals.push_back(node.key);
+            locals.push_back(node.value);
+            locals.push_back("loop");
+            node.body.accept(*this);
+            locals.resize(locals.size() - 3);
+        }
+
+        void visit(const inja::IfStatementNode& node) override {
+            node.condition.accept(*this);
+            node.true_statement.accept(*this);
+            node.false_statement.accept(*this);
+        }
+
+        void visit(const inja::IncludeStatementNode& node) override {
+            visitTemplate(node.file);
+        }
+
+        void visit(const inja::ExtendsStatementNode& node) override {
+            visitTemplate(node.file);
+        }
+
+        void visit(const inja::BlockStatementNode& node) override {
+            node.block.accept(*this);
+        }
+
+        void visit(const inja::SetStatementNode& node) override {
+            node.expression.accept(*this);
+            locals.push_back(node.key);
+        }
+    };
+}
+
+bool TemplateDependencies::reads(const std::string& prefix) const {
+    for (auto it = variables.lower_bound(prefix); it != variables.end(); ++it) {
+        if (it->compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        if (it->size() == prefix.size() || (*it)[prefix.size()] == '.') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TemplateDependencies::readsFieldOutside(const std::string& field, const std::set<std::string>& bound) const {
+    if (dynamic || all_fields) {
+        return true;
+    }
+
+    for (const auto* names : { &variables, &local_variables }) {
+        for (const auto& name : *names) {
+            // every segment after the head, as the dotted name ending in it
+            for (std::size_t start = name.find('.'); start != std::string::npos;) {
+                std::size_t end = std::min(name.find('.', start + 1), name.size());
+                if (name.compare(start + 1, end - start - 1, field) == 0 && !bound.count(name.substr(0, end))) {
+                    return true;
+                }
+                start = end < name.size() ? end : std::string::npos;
+            }
+        }
+    }
+    return false;
+}
+
+TemplateDependencies analyse_template(const inja::Template& temp, const inja::TemplateStorage& storage) {
+    DependencyVisitor visitor(storage);
+    visitor.visit(temp);
+    return visitor.dependencies;
+}
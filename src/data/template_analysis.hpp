@@ -0,0 +1,38 @@
+#ifndef TEMPLATE_ANALYSIS_HPP_
+#define TEMPLATE_ANALYSIS_HPP_
+
+#include <set>
+#include <string>
+#include <inja.hpp>
+#include "../utils/debug.hpp"
+
+// Data a template reads, found by walking its AST once instead of rendering it.
+struct TemplateDependencies {
+    // dotted data names read by the template and everything it includes or
+    // extends, e.g. "site.pages" or "page.title"; loop and set variables are left out
+    std::set<std::string> variables;
+    // dotted names read through loop and set variables, e.g. "p.title" in a loop over site.pages
+    std::set<std::string> local_variables;
+    // true when data is looked up by a name only known at render time
+    bool dynamic = false;
+    // every segment of every data name, loop and set variables included, e.g. "p" and
+    // "title" for p.title, plus keys given to at() and existsIn() as literals; these
+    // are all the object keys the template can reach by name
+    std::set<std::string> fields;
+    // true when the template may read object keys it does not name, by looping over an
+    // object or passing a computed key to at() or existsIn()
+    bool all_fields = false;
+    // files of the templates it includes or extends, directly or not, as named
+    // in the template storage
+    std::set<std::string> templates;
+
+    // true if any variable is prefix itself or lies below it, e.g. "site.pages" for "site.pages.0.title"
+    bool reads(const std::string& prefix) const;
+    // true if field may be read below anything but the names in bound, e.g. "all_tags"
+    // read as p.all_tags in a loop when bound holds page.all_tags and site.all_tags
+    bool readsFieldOutside(const std::string& field, const std::set<std::string>& bound) const;
+};
+
+TemplateDependencies analyse_template(const inja::Template& temp, const inja::TemplateStorage& storage);
+
+#endif
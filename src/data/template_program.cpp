@@ -0,0 +1,903 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include "template_program.hpp"
+
+namespace {
+    using json = nlohmann::json;
+    using Op = inja::FunctionStorage::Operation;
+
+    // includes nested deeper than this are taken to be recursive
+    constexpr unsigned MAX_INCLUDE_DEPTH = 32;
+
+    struct Unsupported : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    bool truthy(const json* value) {
+        if (value->is_boolean()) {
+            return value->get<bool>();
+        }
+        else if (value->is_number()) {
+            return *value != 0;
+        }
+        else if (value->is_null()) {
+            return false;
+        }
+        return !value->empty();
+    }
+}
+
+class TemplateProgram::Compiler : public inja::NodeVisitor {
+private:
+    TemplateProgram& program;
+    const inja::TemplateStorage& storage;
+
+    // template whose content the nodes being compiled point into, and the chain
+    // of templates being extended, as in inja's renderer
+    const inja::Template* current = nullptr;
+    std::vector<const inja::Template*> template_stack;
+    std::unordered_map<const inja::Template*, std::uint32_t> source_ids;
+    std::vector<std::string> loop_values;       // loop variable of each enclosing loop, outermost first
+    std::set<std::string> local_names;          // heads written by set or bound as object loop keys
+    std::size_t label = 0;                      // texts are not merged across a jump target
+    std::size_t local_writes = 0;
+    unsigned include_depth = 0;
+    bool soft_lookup = false;
+
+    std::uint32_t here() {
+        label = program.instructions.size();
+        return static_cast<std::uint32_t>(label);
+    }
+
+    std::uint32_t emit(Code code, std::size_t pos, std::uint32_t a = 0, std::uint32_t b = 0) {
+        auto source = source_ids.find(current);
+        if (source == source_ids.end()) {
+            source = source_ids.emplace(current, static_cast<std::uint32_t>(program.sources.size())).first;
+            program.sources.push_back(current->content);
+        }
+
+        program.instructions.push_back({ code, a, b });
+        program.locations.push_back({ source->second, pos });
+        return static_cast<std::uint32_t>(program.instructions.size() - 1);
+    }
+
+    void patch(std::uint32_t instruction) {
+        program.instructions[instruction].a = here();
+    }
+
+    std::uint32_t local(const std::string& key) {
+        std::string ptr = "/" + key;
+        std::replace(ptr.begin(), ptr.end(), '.', '/');
+        program.locals.emplace_back(ptr);
+        local_names.insert(key.substr(0, key.find('.')));
+        ++local_writes;
+        return static_cast<std::uint32_t>(program.locals.size() - 1);
+    }
+
+    std::uint32_t path(const std::string& name) {
+        if (name.find_first_of("/~") != std::string::npos) {
+            throw Unsupported("data name '" + name + "' is not a plain dotted name");
+        }
+
+        Path result;
+        result.name = name;
+        std::size_t start = 0;
+        std::size_t end = name.find('.');
+        result.head = name.substr(0, end);
+        while (end != std::string::npos) {
+            start = end + 1;
+            end = name.find('.', start);
+
+            Segment segment;
+            segment.key = name.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            bool digits = !segment.key.empty() && segment.key.size() < 19 && std::all_of(segment.key.begin(), segment.key.end(), [](unsigned char c) { return std::isdigit(c); });
+            // json_pointer rejects leading zeros
+            segment.index = digits && (segment.key.size() == 1 || segment.key[0] != '0')
+                ? static_cast<std::size_t>(std::stoull(segment.key))
+                : std::string::npos;
+            result.tail.push_back(std::move(segment));
+        }
+
+        program.paths.push_back(std::move(result));
+        return static_cast<std::uint32_t>(program.paths.size() - 1);
+    }
+
+    void compile_root(const inja::Template& temp) {
+        const inja::Template* saved = current;
+        current = &temp;
+
+        for (const auto& node : temp.root.nodes) {
+            // nothing after an extends is rendered
+            if (auto* extends = dynamic_cast<const inja::ExtendsStatementNode*>(node.get())) {
+                auto parent = storage.find(extends->file);
+                if (parent == storage.end()) {
+                    throw Unsupported("extends '" + extends->file + "' not found");
+                }
+                template_stack.push_back(&parent->second);
+                compile_root(parent->second);
+                break;
+            }
+            node->accept(*this);
+        }
+        current = saved;
+    }
+
+    void compile_expression(const inja::ExpressionListNode& expression) {
+        if (!expression.root) {
+            throw Unsupported("empty expression");
+        }
+        expression.root->accept(*this);
+    }
+
+    void compile_loop_field(const inja::DataNode& node) {
+        // loop.index, loop.parent.is_last, ...
+        std::size_t parents = 0;
+        std::string rest = node.name.substr(node.name.find('.') + 1);
+        while (rest.compare(0, 7, "parent.") == 0) {
+            ++parents;
+            rest.erase(0, 7);
+        }
+
+        LoopInfo field;
+        if (rest == "index") {
+            field = LoopInfo::Index;
+        }
+        else if (rest == "index1") {
+            field = LoopInfo::Index1;
+        }
+        else if (rest == "is_first") {
+            field = LoopInfo::IsFirst;
+        }
+        else if (rest == "is_last") {
+            field = LoopInfo::IsLast;
+        }
+        else {
+            throw Unsupported("'" + node.name + "' is not a loop field");
+        }
+
+        if (node.name.find('.') == std::string::npos || parents >= loop_values.size()) {
+            throw Unsupported("'" + node.name + "' used outside of a loop deep enough");
+        }
+        emit(Code::LoopField, node.pos, static_cast<std::uint32_t>(field), static_cast<std::uint32_t>(loop_values.size() - 1 - parents));
+    }
+
+    template <typename Loop>
+    void compile_loop(const Loop& node, std::uint32_t key) {
+        compile_expression(node.condition);
+        std::uint32_t begin = emit(Code::ForBegin, node.pos, 0, key);
+
+        std::uint32_t body = here();
+        loop_values.push_back(node.value);
+        program.max_loop_depth = std::max(program.max_loop_depth, static_cast<std::uint32_t>(loop_values.size()));
+        node.body.accept(*this);
+        loop_values.pop_back();
+
+        emit(Code::ForNext, node.pos, body);
+        patch(begin);
+    }
+
+public:
+    Compiler(TemplateProgram& program, const inja::TemplateStorage& storage) :
+        program(program), storage(storage) { }
+
+    void compile(const inja::Template& temp) {
+        template_stack = { &temp };
+        compile_root(temp);
+
+        for (auto& data_path : program.paths) {
+            data_path.local = local_names.count(data_path.head) > 0;
+        }
+    }
+
+    void visit(const inja::BlockNode& node) override {
+        for (const auto& n : node.nodes) {
+            n->accept(*this);
+        }
+    }
+
+    void visit(const inja::TextNode& node) override {
+        if (node.length == 0) {
+            return;
+        }
+
+        std::uint32_t offset = static_cast<std::uint32_t>(program.text.size());
+        program.text.append(current->content, node.pos, node.length);
+
+        // text that follows text is one write, unless something jumps in between
+        if (!program.instructions.empty() && program.instructions.size() > label
+            && program.instructions.back().code == Code::Text) {
+            program.instructions.back().b += static_cast<std::uint32_t>(node.length);
+            return;
+        }
+        emit(Code::Text, node.pos, offset, static_cast<std::uint32_t>(node.length));
+    }
+
+    void visit(const inja::ExpressionNode&) override { }
+    void visit(const inja::StatementNode&) override { }
+    void visit(const inja::ForStatementNode&) override { }
+
+    void visit(const inja::LiteralNode& node) override {
+        program.constants.push_back(node.value);
+        emit(Code::Literal, node.pos, static_cast<std::uint32_t>(program.constants.size() - 1));
+    }
+
+    void visit(const inja::DataNode& node) override {
+        bool soft = std::exchange(soft_lookup, false);
+
+        if (node.head == "loop") {
+            compile_loop_field(node);
+            return;
+        }
+
+        for (std::size_t slot = loop_values.size(); slot-- > 0;) {
+            if (loop_values[slot] == node.head) {
+                emit(Code::LoopValue, node.pos, path(node.name), static_cast<std::uint32_t>(slot) | (soft ? 0x80000000u : 0u));
+                return;
+            }
+        }
+        emit(Code::Data, node.pos, path(node.name), soft ? 1 : 0);
+    }
+
+    void visit(const inja::FunctionNode& node) override {
+        switch (node.operation) {
+        case Op::And:
+        case Op::Or: {
+            node.arguments[0]->accept(*this);
+            std::uint32_t jump = emit(node.operation == Op::And ? Code::AndJump : Code::OrJump, node.pos);
+            node.arguments[1]->accept(*this);
+            emit(Code::ToBool, node.pos);
+            patch(jump);
+        } break;
+        case Op::Default: {
+            // a missing first argument is not an error
+            soft_lookup = dynamic_cast<const inja::DataNode*>(node.arguments[0].get()) != nullptr;
+            node.arguments[0]->accept(*this);
+            soft_lookup = false;
+            std::uint32_t jump = emit(Code::DefaultJump, node.pos);
+            node.arguments[1]->accept(*this);
+            patch(jump);
+        } break;
+        case Op::AtId:
+            // inja resolves the member name against the data first
+            throw Unsupported("member access on the result of a function");
+        case Op::Super:
+        case Op::Callback:
+        case Op::None:
+            throw Unsupported("function '" + node.name + "' is only handled by inja");
+        default: {
+            for (const auto& argument : node.arguments) {
+                argument->accept(*this);
+            }
+            emit(Code::Call, node.pos, static_cast<std::uint32_t>(node.operation), static_cast<std::uint32_t>(node.arguments.size()));
+        } break;
+        }
+    }
+
+    void visit(const inja::ExpressionListNode& node) override {
+        compile_expression(node);
+        emit(Code::Print, node.pos);
+    }
+
+    void visit(const inja::ForArrayStatementNode& node) override {
+        compile_loop(node, NO_KEY);
+    }
+
+    void visit(const inja::ForObjectStatementNode& node) override {
+        compile_loop(node, local(node.key));
+    }
+
+    void visit(const inja::IfStatementNode& node) override {
+        compile_expression(node.condition);
+        std::uint32_t skip_true = emit(Code::JumpIfFalse, node.pos);
+        node.true_statement.accept(*this);
+
+        if (node.has_false_statement) {
+            std::uint32_t skip_false = emit(Code::Jump, node.pos);
+            patch(skip_true);
+            node.false_statement.accept(*this);
+            patch(skip_false);
+        }
+        else {
+            patch(skip_true);
+        }
+    }
+
+    void visit(const inja::IncludeStatementNode& node) override {
+        auto included = storage.find(node.file);
+        if (included == storage.end()) {
+            throw Unsupported("include '" + node.file + "' not found");
+        }
+        if (include_depth == MAX_INCLUDE_DEPTH) {
+            throw Unsupported("includes nested too deeply");
+        }
+
+        // inlined; sets inside the include do not leak out, as it renders with a copy of the caller's data
+        std::uint32_t scope = emit(Code::ScopePush, node.pos);
+        std::size_t writes_before = local_writes;
+        std::vector<const inja::Template*> saved_stack = std::exchange(template_stack, { &included->second });
+        ++include_depth;
+
+        compile_root(included->second);
+
+        --include_depth;
+        template_stack = std::move(saved_stack);
+        if (local_writes == writes_before) {
+            program.instructions[scope] = { Code::Jump, scope + 1, 0 };
+        }
+        else {
+            emit(Code::ScopePop, node.pos);
+        }
+    }
+
+    void visit(const inja::ExtendsStatementNode& node) override {
+        throw Unsupported("extends '" + node.file + "' inside a statement");
+    }
+
+    void visit(const inja::BlockStatementNode& node) override {
+        // blocks always come from the template that started the chain
+        const inja::Template* front = template_stack.front();
+        auto block = front->block_storage.find(node.name);
+        if (block == front->block_storage.end()) {
+            return;
+        }
+
+        const inja::Template* saved = std::exchange(current, front);
+        block->second->block.accept(*this);
+        current = saved;
+    }
+
+    void visit(const inja::SetStatementNode& node) override {
+        std::string head = node.key.substr(0, node.key.find('.'));
+        if (head == "loop" || std::find(loop_values.begin(), loop_values.end(), head) != loop_values.end()) {
+            throw Unsupported("set of loop variable '" + node.key + "'");
+        }
+
+        compile_expression(node.expression);
+        emit(Code::Set, node.pos, local(node.key));
+    }
+};
+
+class TemplateProgram::Machine {
+private:
+    struct Frame {
+        const json* container = nullptr;
+        std::unique_ptr<json> owned;        // containers that live in the locals are copied
+        std::size_t index = 0;
+        std::size_t size = 0;
+        json::const_iterator it;            // object loops only
+        std::uint32_t key = NO_KEY;
+        const json* value = nullptr;
+        std::size_t temporaries = 0;        // temporaries made inside the body are dropped per iteration
+    };
+
+    // a value on the stack, and whether it lives in the locals, which a set may overwrite
+    struct Value {
+        const json* value;
+        bool local;
+
+        Value(const json* value, bool local = false) : value(value), local(local) { }
+    };
+
+    const TemplateProgram& program;
+    const json& data;
+    const inja::DataLayer* layer;
+    std::string& out;
+
+    json locals = json::object();
+    std::vector<json> saved_locals;
+    std::vector<Value> stack;
+    std::deque<json> temporaries;
+    std::vector<Frame> frames;
+    std::size_t ip = 0;
+
+    const json TRUE_VALUE = true;
+    const json FALSE_VALUE = false;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        const Location& location = program.locations[ip];
+        throw inja::RenderError(message, inja::get_source_location(program.sources[location.source], location.pos));
+    }
+
+    const json* push_temporary(json value) {
+        temporaries.push_back(std::move(value));
+        return &temporaries.back();
+    }
+
+    const json* pop() {
+        const json* value = stack.back().value;
+        stack.pop_back();
+        return value;
+    }
+
+    static const json* descend(const json* value, const std::vector<Segment>& segments) {
+        for (const auto& segment : segments) {
+            if (value->is_object()) {
+                auto it = value->find(segment.key);
+                if (it == value->end()) {
+                    return nullptr;
+                }
+                value = &*it;
+            }
+            else if (value->is_array() && segment.index < value->size()) {
+                value = &(*value)[segment.index];
+            }
+            else {
+                return nullptr;
+            }
+        }
+        return value;
+    }
+
+    // as inja: the template's own variables, then the layer, then the data
+    const json* lookup(const Path& path, bool& local) const {
+        if (path.local) {
+            auto it = locals.find(path.head);
+            if (it != locals.end()) {
+                if (const json* value = descend(&*it, path.tail)) {
+                    local = true;
+                    return value;
+                }
+            }
+        }
+
+        if (layer) {
+            for (const auto& [key, value] : *layer) {
+                if (key == path.head) {
+                    if (const json* found = descend(value, path.tail)) {
+                        return found;
+                    }
+                }
+            }
+        }
+
+        auto it = data.find(path.head);
+        return it != data.end() ? descend(&*it, path.tail) : nullptr;
+    }
+
+    void push_lookup(const Path& path, bool soft) {
+        bool local = false;
+        const json* value = lookup(path, local);
+        if (!value && !soft) {
+            fail("variable '" + path.name + "' not found");
+        }
+        stack.push_back({ value, local });
+    }
+
+    void print(const json& value) {
+        if (value.is_string()) {
+            out.append(value.get_ref<const json::string_t&>());
+        }
+        else if (value.is_number_unsigned()) {
+            out.append(std::to_string(value.get<json::number_unsigned_t>()));
+        }
+        else if (value.is_number_integer()) {
+            out.append(std::to_string(value.get<json::number_integer_t>()));
+        }
+        else if (!value.is_null()) {
+            out.append(value.dump());
+        }
+    }
+
+    bool exists(const std::string& name) const {
+        std::string head(inja::DataNode::split_head(name));
+        json::json_pointer tail = inja::DataNode::convert_tail_to_ptr(name);
+        if (layer) {
+            for (const auto& [key, value] : *layer) {
+                if (key == head && value->contains(tail)) {
+                    return true;
+                }
+            }
+        }
+        return data.contains(json::json_pointer(inja::DataNode::convert_dot_to_ptr(name)));
+    }
+
+    void call(Op operation, std::uint32_t count) {
+        const json* args[2] = { nullptr, nullptr };
+        // results that point into an argument live where it does
+        bool local = false;
+        for (std::uint32_t i = count; i-- > 0;) {
+            local = local || stack.back().local;
+            const json* value = pop();
+            if (i < 2) {
+                args[i] = value;
+            }
+        }
+
+        switch (operation) {
+        case Op::Not:
+            stack.push_back(truthy(args[0]) ? &FALSE_VALUE : &TRUE_VALUE);
+            break;
+        case Op::In:
+            stack.push_back(std::find(args[1]->begin(), args[1]->end(), *args[0]) != args[1]->end() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Equal:
+            stack.push_back(*args[0] == *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::NotEqual:
+            stack.push_back(*args[0] != *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Greater:
+            stack.push_back(*args[0] > *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::GreaterEqual:
+            stack.push_back(*args[0] >= *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Less:
+            stack.push_back(*args[0] < *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::LessEqual:
+            stack.push_back(*args[0] <= *args[1] ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Add:
+            if (args[0]->is_string() && args[1]->is_string()) {
+                stack.push_back(push_temporary(args[0]->get_ref<const json::string_t&>() + args[1]->get_ref<const json::string_t&>()));
+            }
+            else if (args[0]->is_number_integer() && args[1]->is_number_integer()) {
+                stack.push_back(push_temporary(args[0]->get<json::number_integer_t>() + args[1]->get<json::number_integer_t>()));
+            }
+            else {
+                stack.push_back(push_temporary(args[0]->get<json::number_float_t>() + args[1]->get<json::number_float_t>()));
+            }
+            break;
+        case Op::Subtract:
+            if (args[0]->is_number_integer() && args[1]->is_number_integer()) {
+                stack.push_back(push_temporary(args[0]->get<json::number_integer_t>() - args[1]->get<json::number_integer_t>()));
+            }
+            else {
+                stack.push_back(push_temporary(args[0]->get<json::number_float_t>() - args[1]->get<json::number_float_t>()));
+            }
+            break;
+        case Op::Multiplication:
+            if (args[0]->is_number_integer() && args[1]->is_number_integer()) {
+                stack.push_back(push_temporary(args[0]->get<json::number_integer_t>() * args[1]->get<json::number_integer_t>()));
+            }
+            else {
+                stack.push_back(push_temporary(args[0]->get<json::number_float_t>() * args[1]->get<json::number_float_t>()));
+            }
+            break;
+        case Op::Division:
+            if (args[1]->get<json::number_float_t>() == 0) {
+                fail("division by zero");
+            }
+            stack.push_back(push_temporary(args[0]->get<json::number_float_t>() / args[1]->get<json::number_float_t>()));
+            break;
+        case Op::Power:
+            if (args[0]->is_number_integer() && args[1]->get<json::number_integer_t>() >= 0) {
+                stack.push_back(push_temporary(static_cast<json::number_integer_t>(
+                    std::pow(args[0]->get<json::number_integer_t>(), args[1]->get<json::number_integer_t>()))));
+            }
+            else {
+                stack.push_back(push_temporary(std::pow(args[0]->get<json::number_float_t>(), args[1]->get<json::number_integer_t>())));
+            }
+            break;
+        case Op::Modulo:
+            stack.push_back(push_temporary(args[0]->get<json::number_integer_t>() % args[1]->get<json::number_integer_t>()));
+            break;
+        case Op::At:
+            if (args[0]->is_object()) {
+                stack.push_back({ &args[0]->at(args[1]->get<std::string>()), local });
+            }
+            else {
+                stack.push_back({ &args[0]->at(args[1]->get<int>()), local });
+            }
+            break;
+        case Op::Capitalize: {
+            auto result = args[0]->get<json::string_t>();
+            if (!result.empty()) {
+                result[0] = static_cast<char>(::toupper(result[0]));
+                std::transform(result.begin() + 1, result.end(), result.begin() + 1, [](char c) { return static_cast<char>(::tolower(c)); });
+            }
+            stack.push_back(push_temporary(std::move(result)));
+        } break;
+        case Op::DivisibleBy: {
+            const auto divisor = args[1]->get<json::number_integer_t>();
+            stack.push_back((divisor != 0) && (args[0]->get<json::number_integer_t>() % divisor == 0) ? &TRUE_VALUE : &FALSE_VALUE);
+        } break;
+        case Op::Even:
+            stack.push_back(args[0]->get<json::number_integer_t>() % 2 == 0 ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Odd:
+            stack.push_back(args[0]->get<json::number_integer_t>() % 2 != 0 ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Exists:
+            stack.push_back(exists(args[0]->get_ref<const json::string_t&>()) ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::ExistsInObject:
+            stack.push_back(args[0]->find(args[1]->get_ref<const json::string_t&>()) != args[0]->end() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::First:
+            stack.push_back({ &args[0]->front(), local });
+            break;
+        case Op::Last:
+            stack.push_back({ &args[0]->back(), local });
+            break;
+        case Op::Float:
+            stack.push_back(push_temporary(std::stod(args[0]->get_ref<const json::string_t&>())));
+            break;
+        case Op::Int:
+            stack.push_back(push_temporary(std::stoi(args[0]->get_ref<const json::string_t&>())));
+            break;
+        case Op::IsArray:
+            stack.push_back(args[0]->is_array() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsBoolean:
+            stack.push_back(args[0]->is_boolean() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsFloat:
+            stack.push_back(args[0]->is_number_float() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsInteger:
+            stack.push_back(args[0]->is_number_integer() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsNumber:
+            stack.push_back(args[0]->is_number() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsObject:
+            stack.push_back(args[0]->is_object() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::IsString:
+            stack.push_back(args[0]->is_string() ? &TRUE_VALUE : &FALSE_VALUE);
+            break;
+        case Op::Length:
+            if (args[0]->is_string()) {
+                stack.push_back(push_temporary(args[0]->get_ref<const json::string_t&>().length()));
+            }
+            else {
+                stack.push_back(push_temporary(args[0]->size()));
+            }
+            break;
+        case Op::Lower:
+        case Op::Upper: {
+            auto result = args[0]->get<json::string_t>();
+            auto convert = operation == Op::Lower ? ::tolower : ::toupper;
+            std::transform(result.begin(), result.end(), result.begin(), [convert](char c) { return static_cast<char>(convert(c)); });
+            stack.push_back(push_temporary(std::move(result)));
+        } break;
+        case Op::Max:
+            stack.push_back({ &*std::max_element(args[0]->begin(), args[0]->end()), local });
+            break;
+        case Op::Min:
+            stack.push_back({ &*std::min_element(args[0]->begin(), args[0]->end()), local });
+            break;
+        case Op::Range: {
+            std::vector<int> result(args[0]->get<json::number_integer_t>());
+            std::iota(result.begin(), result.end(), 0);
+            stack.push_back(push_temporary(std::move(result)));
+        } break;
+        case Op::Round: {
+            const auto precision = args[1]->get<json::number_integer_t>();
+            const double result = std::round(args[0]->get<json::number_float_t>() * std::pow(10.0, precision)) / std::pow(10.0, precision);
+            stack.push_back(precision == 0 ? push_temporary(int(result)) : push_temporary(result));
+        } break;
+        case Op::Sort: {
+            json result = args[0]->get<std::vector<json>>();
+            std::sort(result.begin(), result.end());
+            stack.push_back(push_temporary(std::move(result)));
+        } break;
+        case Op::Join: {
+            const auto separator = args[1]->get<json::string_t>();
+            std::string result;
+            std::string sep;
+            for (const auto& value : *args[0]) {
+                result += sep;
+                result += value.is_string() ? value.get<std::string>() : value.dump();
+                sep = separator;
+            }
+            stack.push_back(push_temporary(std::move(result)));
+        } break;
+        default:
+            fail("unsupported function");
+        }
+    }
+
+    // false once the container is exhausted
+    bool bind_current(Frame& frame) {
+        if (frame.index >= frame.size) {
+            return false;
+        }
+        if (frame.key == NO_KEY) {
+            frame.value = &(*frame.container)[frame.index];
+        }
+        else {
+            locals[program.locals[frame.key]] = frame.it.key();
+            frame.value = &frame.it.value();
+        }
+        return true;
+    }
+
+    void begin_loop(std::uint32_t key, std::uint32_t exit) {
+        const bool local = stack.back().local;
+        const json* container = pop();
+        if (key == NO_KEY ? !container->is_array() : !container->is_object()) {
+            fail(key == NO_KEY ? "object must be an array" : "object must be an object");
+        }
+
+        frames.emplace_back();
+        Frame& frame = frames.back();
+        // the body may overwrite the template's own variables
+        if (local) {
+            frame.owned = std::make_unique<json>(*container);
+            container = frame.owned.get();
+        }
+        frame.container = container;
+        frame.size = container->size();
+        frame.key = key;
+        frame.temporaries = temporaries.size();
+        if (key != NO_KEY) {
+            frame.it = container->cbegin();
+        }
+
+        if (!bind_current(frame)) {
+            end_loop();
+            ip = exit;
+            return;
+        }
+        ++ip;
+    }
+
+    void end_loop() {
+        Frame& frame = frames.back();
+        if (frame.key != NO_KEY) {
+            // inja leaves the key variable behind, cleared
+            locals[program.locals[frame.key]] = "";
+        }
+        frames.pop_back();
+    }
+
+    void next_iteration(std::uint32_t body) {
+        Frame& frame = frames.back();
+        temporaries.resize(frame.temporaries);
+        ++frame.index;
+        if (frame.key != NO_KEY) {
+            ++frame.it;
+        }
+
+        if (bind_current(frame)) {
+            ip = body;
+            return;
+        }
+        end_loop();
+        ++ip;
+    }
+
+    const json* loop_field(LoopInfo field, std::uint32_t slot) {
+        const Frame& frame = frames[slot];
+        switch (field) {
+        case LoopInfo::Index:
+            return push_temporary(frame.index);
+        case LoopInfo::Index1:
+            return push_temporary(frame.index + 1);
+        case LoopInfo::IsFirst:
+            return frame.index == 0 ? &TRUE_VALUE : &FALSE_VALUE;
+        case LoopInfo::IsLast:
+            return frame.index + 1 == frame.size ? &TRUE_VALUE : &FALSE_VALUE;
+        }
+        return nullptr;
+    }
+
+public:
+    Machine(const TemplateProgram& program, const json& data, const inja::DataLayer* layer, std::string& out) :
+        program(program), data(data), layer(layer), out(out)
+    {
+        // frames never move, so pointers into them stay valid
+        frames.reserve(program.max_loop_depth);
+    }
+
+    void run() {
+        const std::vector<Instruction>& instructions = program.instructions;
+        while (ip < instructions.size()) {
+            const Instruction& instruction = instructions[ip];
+            switch (instruction.code) {
+            case Code::Text:
+                out.append(program.text, instruction.a, instruction.b);
+                break;
+            case Code::Print:
+                print(*pop());
+                break;
+            case Code::Jump:
+                ip = instruction.a;
+                continue;
+            case Code::JumpIfFalse:
+                if (!truthy(pop())) {
+                    ip = instruction.a;
+                    continue;
+                }
+                break;
+            case Code::Literal:
+                stack.push_back(&program.constants[instruction.a]);
+                break;
+            case Code::Data:
+                push_lookup(program.paths[instruction.a], instruction.b != 0);
+                break;
+            case Code::LoopValue: {
+                const Path& path = program.paths[instruction.a];
+                const json* value = descend(frames[instruction.b & 0x7fffffffu].value, path.tail);
+                if (value) {
+                    stack.push_back(value);
+                }
+                else {
+                    push_lookup(path, (instruction.b & 0x80000000u) != 0);
+                }
+            } break;
+            case Code::LoopField:
+                stack.push_back(loop_field(static_cast<LoopInfo>(instruction.a), instruction.b));
+                break;
+            case Code::Call:
+                call(static_cast<Op>(instruction.a), instruction.b);
+                break;
+            case Code::AndJump:
+                if (!truthy(pop())) {
+                    stack.push_back(&FALSE_VALUE);
+                    ip = instruction.a;
+                    continue;
+                }
+                break;
+            case Code::OrJump:
+                if (truthy(pop())) {
+                    stack.push_back(&TRUE_VALUE);
+                    ip = instruction.a;
+                    continue;
+                }
+                break;
+            case Code::DefaultJump:
+                if (stack.back().value) {
+                    ip = instruction.a;
+                    continue;
+                }
+                stack.pop_back();
+                break;
+            case Code::ToBool:
+                stack.back() = truthy(stack.back().value) ? &TRUE_VALUE : &FALSE_VALUE;
+                break;
+            case Code::ForBegin:
+                begin_loop(instruction.b, instruction.a);
+                continue;
+            case Code::ForNext:
+                next_iteration(instruction.a);
+                continue;
+            case Code::Set:
+                locals[program.locals[instruction.a]] = *pop();
+                break;
+            case Code::ScopePush:
+                saved_locals.push_back(locals);
+                break;
+            case Code::ScopePop:
+                locals = std::move(saved_locals.back());
+                saved_locals.pop_back();
+                break;
+            }
+            ++ip;
+        }
+    }
+};
+
+std::unique_ptr<TemplateProgram> TemplateProgram::compile(
+    const inja::Template& temp,
+    const inja::TemplateStorage& storage,
+    std::string* reason
+)
+{
+    auto program = std::unique_ptr<TemplateProgram>(new TemplateProgram());
+    try {
+        Compiler(*program, storage).compile(temp);
+    }
+    catch (const Unsupported& e) {
+        if (reason) {
+            *reason = e.what();
+        }
+        return nullptr;
+    }
+    return program;
+}
+
+void TemplateProgram::render_to(std::string& out, const nlohmann::json& data, const inja::DataLayer* layer) const {
+    Machine(*this, data, layer, out).run();
+}
@@ -0,0 +1,95 @@
+#ifndef TEMPLATE_PROGRAM_HPP_
+#define TEMPLATE_PROGRAM_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <inja.hpp>
+#include <nlohmann/json.hpp>
+#include "../utils/debug.hpp"
+
+// An inja template compiled to a flat list of instructions. Text is copied into
+// one string, data names are split into path segments once, loop variables and
+// loop.* fields become direct slot accesses, includes are inlined and extends/block
+// inheritance is resolved at compile time. A single loop then renders a page
+// without walking the AST.
+// Output matches inja's renderer with default settings (no HTML autoescape, no
+// callbacks); templates using anything else are left to inja.
+class TemplateProgram {
+public:
+    // null if the template uses something only inja's renderer handles; reason says what
+    static std::unique_ptr<TemplateProgram> compile(
+        const inja::Template& temp,
+        const inja::TemplateStorage& storage,
+        std::string* reason = nullptr
+    );
+
+    // appends to out; layer is looked up as in inja::Environment::render_to
+    void render_to(std::string& out, const nlohmann::json& data, const inja::DataLayer* layer = nullptr) const;
+
+    std::size_t size() const { return instructions.size(); }
+
+private:
+    class Compiler;
+    class Machine;
+
+    enum class Code : std::uint8_t {
+        Text,           // a: offset into text, b: length
+        Print,          // pops a value and prints it
+        Jump,           // a: target
+        JumpIfFalse,    // pops a condition; a: target
+        Literal,        // a: constant
+        Data,           // a: path; b: 1 to push null instead of failing when missing
+        LoopValue,      // a: path, b: loop slot; falls back to Data when the path is missing
+        LoopField,      // a: field, b: loop slot
+        Call,           // a: operation, b: argument count
+        AndJump,        // pops; if falsy pushes false and jumps to a
+        OrJump,         // pops; if truthy pushes true and jumps to a
+        DefaultJump,    // pops; if found pushes it back and jumps to a
+        ToBool,         // replaces the top of the stack with its truthiness
+        ForBegin,       // pops the container; a: loop exit, b: key local (object loops) or NO_KEY
+        ForNext,        // a: first instruction of the body
+        Set,            // pops a value; a: pointer into the locals
+        ScopePush,      // saves the locals, as an include gets a copy of its caller's
+        ScopePop,
+    };
+
+    enum class LoopInfo : std::uint8_t { Index, Index1, IsFirst, IsLast };
+
+    struct Instruction {
+        Code code;
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+    };
+
+    struct Segment {
+        std::string key;
+        std::size_t index;              // npos unless key is a valid array index
+    };
+
+    struct Path {
+        std::string name;               // as written, for error messages
+        std::string head;
+        std::vector<Segment> tail;
+        bool local = false;             // head may be set by the template itself
+    };
+
+    struct Location {
+        std::uint32_t source;           // index into sources
+        std::size_t pos;
+    };
+
+    static constexpr std::uint32_t NO_KEY = UINT32_MAX;
+
+    std::string text;
+    std::vector<Instruction> instructions;
+    std::vector<Location> locations;    // one per instruction, for error messages
+    std::vector<std::string> sources;   // content of every template compiled in, so the program outlives the storage
+    std::vector<nlohmann::json> constants;
+    std::vector<Path> paths;
+    std::vector<nlohmann::json::json_pointer> locals;
+    std::uint32_t max_loop_depth = 0;
+};
+
+#endif
@@ -4,12 +4,15 @@
 #include <nlohmann/json.hpp>
 #include <inja.hpp>
 #include "../data/config.hpp"
+#include "../utils/thread_pool.hpp"
 #include "../utils/debug.hpp"
 #include <inja.hpp>
 
 class Directive {
 public:
-	virtual void init(Config& config, const nlohmann::json directive) = 0;
+	// collects the directive's site data; its pages are only written when render is
+	// set, otherwise the outputs of the previous build are known to be current
+	virtual void init(Config& config, ThreadPool& pool, const nlohmann::json directive, bool render) = 0;
 };
 
 std::unique_ptr<Directive> getDirective(const std::string& name);
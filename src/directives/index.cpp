@@ -1,15 +1,17 @@
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #include "index.hpp"
+#include "../utils/string_output.hpp"
 
 Index::Index() { }
 
-void Index::init(Config& config, const nlohmann::json directive)
+void Index::init(Config& config, ThreadPool& pool, const nlohmann::json directive, bool render)
 {
-    nlohmann::json data = config.getData().getJson();
-
     if (!directive.contains("count")) {
         throw std::runtime_error("Index directive missing required 'count' value");
     }
@@ -20,44 +22,64 @@ void Index::init(Config& config, const nlohmann::json directive)
         throw std::runtime_error("Index directive requires a positive 'count' value");
     }
 
-    if (!data.contains("site") || !data["site"].contains("pages")) {
-        LOG_WARN("No pages available for index directive");
+    const PageStore& page_store = config.getPageStore();
+    if (page_store.empty()) {
+        LOG_WARN("Index directive found no pages to render");
         return;
     }
 
-    const nlohmann::json& pages = data["site"]["pages"];
-    if (!pages.is_array() || pages.empty()) {
-        LOG_WARN("Index directive found no pages to render");
+    if (!render) {
         return;
     }
 
-    // make a filtered copy
-    nlohmann::json pages_filtered = nlohmann::json::array();
-    for (const auto& page : pages) {
-        // treat missing/non-bool as false
-        if (page.is_object() && page.value("indexable", false)) {
-            pages_filtered.push_back(page);
-        }
+    // the pages stay where they are; pagination only copies one window at a time
+    std::vector<const nlohmann::json*> pages_filtered;
+    for (std::size_t position : page_store.indexablePositions()) {
+        pages_filtered.push_back(&page_store.view(position));
     }
 
-    const inja::Template& temp = config.getTemplate(directive["name"]);
-
     std::filesystem::path output_dir = config.getSiteDirectory() / "output";
 
-    render_paginated(config, temp, data, pages_filtered, count, output_dir);
+    render_paginated(config, pool, directive["name"], pages_filtered, count, output_dir, read_aliases(directive));
+}
+
+Index::Aliases Index::read_aliases(const nlohmann::json& directive) {
+    if (!directive.contains("aliases")) {
+        return Aliases::Copy;
+    }
+
+    const std::string aliases = directive["aliases"].get<std::string>();
+    if (aliases == "copy") {
+        return Aliases::Copy;
+    }
+    else if (aliases == "hardlink") {
+        return Aliases::HardLink;
+    }
+    else if (aliases == "symlink") {
+        return Aliases::SymLink;
+    }
+    else if (aliases == "omit") {
+        return Aliases::Omit;
+    }
+
+    std::stringstream ss;
+    ss << "Unknown 'aliases' value '" << aliases << "' in directive '" << directive["name"].get<std::string>()
+       << "', expected copy, hardlink, symlink or omit";
+    throw std::runtime_error(ss.str());
 }
 
 void Index::render_paginated(
     Config& config,
-    const inja::Template& temp,
-    const nlohmann::json& base_data,
-    const nlohmann::json& pages,
+    ThreadPool& pool,
+    const std::string& template_name,
+    const std::vector<const nlohmann::json*>& pages,
     int count,
     const std::filesystem::path& output_dir,
+    Aliases aliases,
     const AugmentRenderData& augment
 )
 {
-    if (!pages.is_array() || pages.empty()) {
+    if (pages.empty()) {
         LOG_WARN("Index pagination received no pages to render");
         return;
     }
@@ -66,64 +88,97 @@ void Index::render_paginated(
         throw std::runtime_error("Index pagination requires a positive 'count' value");
     }
 
-    std::size_t total_pages = (pages.size() + static_cast<std::size_t>(count) - 1) / static_cast<std::size_t>(count);
+    std::size_t page_size = static_cast<std::size_t>(count);
+    std::size_t total_pages = (pages.size() + page_size - 1) / page_size;
 
-    inja::Environment& env = config.getEnvironment();
-
-    for (std::size_t idx = 0; idx < total_pages; ++idx) {
-        std::size_t start = idx * static_cast<std::size_t>(count);
-        std::size_t end = std::min(start + static_cast<std::size_t>(count), pages.size());
+    // pages are rendered independently
+    std::atomic<bool> link_failed{ false };
+    utils::parallel_for(pool, total_pages, [&](std::size_t idx) {
+        render_page(config, template_name, pages, page_size, idx, output_dir, aliases, link_failed, augment);
+    }, 1);
+}
 
-        nlohmann::json subset = nlohmann::json::array();
-        for (std::size_t i = start; i < end; ++i) {
-            subset.push_back(pages[i]);
-        }
+void Index::render_page(
+    Config& config,
+    const std::string& template_name,
+    const std::vector<const nlohmann::json*>& pages,
+    std::size_t count,
+    std::size_t idx,
+    const std::filesystem::path& output_dir,
+    Aliases aliases,
+    std::atomic<bool>& link_failed,
+    const AugmentRenderData& augment
+)
+{
+    std::size_t total_pages = (pages.size() + count - 1) / count;
+    std::size_t start = idx * count;
+    std::size_t end = std::min(start + count, pages.size());
+
+    // site.pages is the window too; the rest of site falls through to the shared data
+    nlohmann::json site_overlay = nlohmann::json::object();
+    nlohmann::json& window = site_overlay["pages"];
+    window = nlohmann::json::array();
+    for (std::size_t i = start; i < end; ++i) {
+        window.push_back(*pages[i]);
+    }
 
-        nlohmann::json render_data = base_data;
-        render_data["pages"] = subset;
-        render_data["site"]["pages"] = subset;
-
-        nlohmann::json index_info;
-        render_data["pages"] = subset;
-        index_info["page_number"] = idx + 1;
-        index_info["total_pages"] = total_pages;
-        index_info["has_previous"] = idx > 0;
-        index_info["count"] = pages.size();
-        index_info["has_next"] = idx + 1 < total_pages;
-        if (idx > 0) {
-            index_info["previous_page"] = idx;
-        }
-        if (idx + 1 < total_pages) {
-            index_info["next_page"] = idx + 2;
-        }
+    nlohmann::json index_info;
+    index_info["page_number"] = idx + 1;
+    index_info["total_pages"] = total_pages;
+    index_info["has_previous"] = idx > 0;
+    index_info["count"] = pages.size();
+    index_info["has_next"] = idx + 1 < total_pages;
+    if (idx > 0) {
+        index_info["previous_page"] = idx;
+    }
+    if (idx + 1 < total_pages) {
+        index_info["next_page"] = idx + 2;
+    }
+    const nlohmann::json page_number = idx + 1;
 
-        render_data["index"] = index_info;
-        render_data["page_number"] = idx + 1;
+    RenderContext context(config.getData());
+    context.bind("site", site_overlay)
+        .bind("pages", window)
+        .bind("index", index_info)
+        .bind("page_number", page_number);
 
-        if (augment) {
-            augment(render_data, idx, total_pages);
-        }
+    nlohmann::json augmented = nlohmann::json::object();
+    if (augment) {
+        augment(context, augmented, site_overlay, idx, total_pages);
+    }
 
-        std::string rendered = env.render(temp, render_data);
+    std::string& rendered = utils::render_buffer();
+    context.render_to(config, template_name, rendered);
 
-        std::filesystem::path root_index = output_dir / "index.html";
-        if (idx == 0) {
-            std::filesystem::path out = root_index;
-            utils::output_file(rendered, out);
-        }
+    // written once; the other locations of the page are aliases of it
+    std::string page_number_str = std::to_string(idx + 1);
+    std::filesystem::path numbered_path = output_dir / page_number_str / "index.html";
+    std::filesystem::path primary_path = idx == 0 ? output_dir / "index.html" : numbered_path;
+    if (!config.getOutput().write(rendered, primary_path)) {
+        LOG_ERROR("Failed outputting file: " << primary_path);
+        return;
+    }
 
-        std::string page_number_str = std::to_string(idx + 1);
+    if (aliases == Aliases::Omit) {
+        return;
+    }
 
-        std::filesystem::path numbered_path = output_dir / page_number_str / "index.html";
-        {
-            std::filesystem::path out = numbered_path;
-            utils::output_file(rendered, out);
+    std::vector<std::filesystem::path> alias_paths;
+    if (idx == 0) {
+        alias_paths.push_back(numbered_path);
+    }
+    alias_paths.push_back(output_dir / "pages" / page_number_str / "index.html");
+
+    for (const auto& alias_path : alias_paths) {
+        bool copy = aliases == Aliases::Copy || link_failed.load(std::memory_order_relaxed);
+        if (!copy && !config.getOutput().link(primary_path, alias_path, aliases == Aliases::SymLink)) {
+            if (!link_failed.exchange(true)) {
+                LOG_WARN("Failed to link " << alias_path << ", writing copies of pagination pages instead");
+            }
+            copy = true;
         }
-
-        std::filesystem::path paged_path = output_dir / "pages" / page_number_str / "index.html";
-        {
-            std::filesystem::path out = paged_path;
-            utils::output_file(rendered, out);
+        if (copy) {
+            config.getOutput().write(rendered, alias_path);
         }
     }
 }
@@ -1,8 +1,11 @@
 #ifndef INDEX_HPP_
 #define INDEX_HPP_
 
+#include <atomic>
 #include <filesystem>
 #include <functional>
+#include <string>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 #include <inja.hpp>
@@ -10,22 +13,49 @@
 #include "directive.hpp"
 #include "../utils/debug.hpp"
 #include "../data/config.hpp"
+#include "../data/render_context.hpp"
 #include "../utils/utils.hpp"
 
 class Index : public Directive {
 public:
     Index();
-    virtual void init(Config& config, const nlohmann::json directive);
+    virtual void init(Config& config, ThreadPool& pool, const nlohmann::json directive, bool render);
 
-    using AugmentRenderData = std::function<void(nlohmann::json&, std::size_t, std::size_t)>;
+    // binds extra per-page values, keeping them in the given object, which lives until the page
+    // is rendered; gets an object whose "pages" is the page's window of pages, so it can be
+    // bound by reference, the page index and the page count. Called from several threads at once.
+    using AugmentRenderData = std::function<void(RenderContext&, nlohmann::json&, const nlohmann::json&, std::size_t, std::size_t)>;
 
+    // how the extra locations of a rendered page (1/index.html next to index.html,
+    // and pages/N/index.html next to N/index.html) are produced
+    enum class Aliases { Copy, HardLink, SymLink, Omit };
+
+    // the directive's optional "aliases" value: "copy" (default), "hardlink", "symlink" or "omit"
+    static Aliases read_aliases(const nlohmann::json& directive);
+
+    // renders the pages on pool and waits for them
     static void render_paginated(
         Config& config,
-        const inja::Template& temp,
-        const nlohmann::json& base_data,
-        const nlohmann::json& pages,
+        ThreadPool& pool,
+        const std::string& template_name,
+        const std::vector<const nlohmann::json*>& pages,
         int count,
         const std::filesystem::path& output_dir,
+        Aliases aliases,
+        const AugmentRenderData& augment = nullptr
+    );
+
+    // renders page idx of the pages split count to a page, on the calling thread;
+    // a failed link sets link_failed, which makes every later alias a copy
+    static void render_page(
+        Config& config,
+        const std::string& template_name,
+        const std::vector<const nlohmann::json*>& pages,
+        std::size_t count,
+        std::size_t idx,
+        const std::filesystem::path& output_dir,
+        Aliases aliases,
+        std::atomic<bool>& link_failed,
         const AugmentRenderData& augment = nullptr
     );
 };
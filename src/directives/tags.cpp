@@ -1,121 +1,56 @@
-#include <algorithm>
-#include <cctype>
+#include <atomic>
 #include <filesystem>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tags.hpp"
 #include "index.hpp"
+#include "../utils/string_output.hpp"
 
-namespace {
-    std::string slugify(const std::string& value)
-    {
-        std::string slug;
-        slug.reserve(value.size());
-
-        bool last_was_hyphen = false;
-        for (unsigned char c : value) {
-            if (std::isalnum(c)) {
-                slug.push_back(static_cast<char>(std::tolower(c)));
-                last_was_hyphen = false;
-            }
-            else if (std::isspace(c) || c == '-' || c == '_' || c == '/') {
-                if (!last_was_hyphen && !slug.empty()) {
-                    slug.push_back('-');
-                    last_was_hyphen = true;
-                }
-            }
-        }
-
-        while (!slug.empty() && slug.back() == '-') {
-            slug.pop_back();
-        }
-
-        if (slug.empty()) {
-            slug = "tag";
-        }
-
-        return slug;
-    }
-}
-
-void Tags::init(Config& config, const nlohmann::json directive)
+void Tags::init(Config& config, ThreadPool& pool, const nlohmann::json directive, bool render)
 {
-    nlohmann::json data = config.getData().getJson();
+    const nlohmann::json& data = config.getData().getJsonRef();
 
-    if (!data.contains("site") || !data["site"].contains("pages")) {
-        LOG_WARN("No pages available for tags directive");
+    const PageStore& page_store = config.getPageStore();
+    if (page_store.empty()) {
+        LOG_WARN("Tags directive found no pages to render");
         return;
     }
 
-    const nlohmann::json& pages = data["site"]["pages"];
-    if (!pages.is_array() || pages.empty()) {
-        LOG_WARN("Tags directive found no pages to render");
+    // filled while the pages were stored in site order
+    const TagIndex& tag_index = config.getTagIndex();
+    if (tag_index.byName().empty()) {
+        LOG_WARN("Tags directive found no tags to process");
         return;
     }
 
-    std::unordered_map<std::string, nlohmann::json> tags_map;
-
-    for (const auto& page : pages) {
-        if (!page.contains("tags") || !page["tags"].is_array()) {
-            continue;
-        }
-
-        for (const auto& tag_value : page["tags"]) {
-            if (!tag_value.is_string()) {
-                continue;
+    // each tag's pages are copied out of site.pages only for themes that read them from
+    // site.tags, such as t.pages in a loop; tag archives use the posting lists directly
+    nlohmann::json tags_data = tag_index.summary();
+    if (config.templatesReadField("pages", { "site.pages", "tag.pages" })) {
+        for (std::size_t i = 0; i < tag_index.byName().size(); ++i) {
+            nlohmann::json& tag_pages = tags_data[i]["pages"];
+            tag_pages = nlohmann::json::array();
+            for (std::size_t position : tag_index.get(tag_index.byName()[i]).pages) {
+                tag_pages.push_back(page_store.view(position));
             }
-
-            std::string tag_name = tag_value.get<std::string>();
-            std::string slug = slugify(tag_name);
-
-            nlohmann::json& tag_entry = tags_map[slug];
-            if (tag_entry.is_null()) {
-                tag_entry = nlohmann::json::object();
-                tag_entry["name"] = tag_name;
-                tag_entry["slug"] = slug;
-                tag_entry["pages"] = nlohmann::json::array();
-                tag_entry["count"] = 0;
-            }
-
-            tag_entry["pages"].push_back(page);
-            tag_entry["count"] = tag_entry["count"] + 1;
         }
     }
-
-    if (tags_map.empty()) {
-        LOG_WARN("Tags directive found no tags to process");
+    config.getData().set<nlohmann::json>(std::move(tags_data), "site", "tags");
+    if (!render) {
         return;
     }
-
-    std::vector<nlohmann::json> tag_collection;
-    tag_collection.reserve(tags_map.size());
-    for (auto& [slug, entry] : tags_map) {
-        entry["count"] = entry["pages"].size();
-        tag_collection.push_back(entry);
-    }
-
-    std::sort(
-        tag_collection.begin(),
-        tag_collection.end(),
-        [](const nlohmann::json& a, const nlohmann::json& b) {
-            return a["name"].get<std::string>() < b["name"].get<std::string>();
-        }
-    );
-
-    config.getData().set<nlohmann::json>(tag_collection, "site", "tags");
-    data["site"]["tags"] = tag_collection;
-
+    const nlohmann::json& tags = data["site"]["tags"];
 
     if (!directive.contains("tags_index") || !directive["tags_index"].is_string()) {
         throw std::runtime_error("Tags directive missing required 'tags_index' template key");
     }
 
     const std::string tags_index_template_name = directive["tags_index"].get<std::string>();
-    const inja::Template& tags_index_template = config.getTemplate(tags_index_template_name);
-    const inja::Template& temp = config.getTemplate(directive["name"]);
+    const std::string template_name = directive["name"].get<std::string>();
+    const Index::Aliases aliases = Index::read_aliases(directive);
     std::filesystem::path tags_output_dir = config.getSiteDirectory() / "output" / "tags";
 
     int directive_count = -1;
@@ -126,40 +61,72 @@ void Tags::init(Config& config, const nlohmann::json directive)
         }
     }
 
-    {
-        nlohmann::json render_data = data;
-        render_data["tags"] = tag_collection;
-        render_data["site"]["tags"] = tag_collection;
+    // the tags index and every page of every tag are independent; they are rendered as one
+    // flat batch, so no task waits on a nested group of its own
+    struct TagPages {
+        const TagIndex::Tag* tag;
+        std::vector<const nlohmann::json*> pages;
+        std::size_t count;
+    };
+    std::vector<TagPages> tag_pages;
+    std::vector<std::pair<std::size_t, std::size_t>> jobs;  // (tag, page index)
+    tag_pages.reserve(tag_index.byName().size());
+    for (TagIndex::Id id : tag_index.byName()) {
+        const TagIndex::Tag& tag = tag_index.get(id);
+        if (tag.pages.empty()) {
+            LOG_WARN("Index pagination received no pages to render");
+            continue;
+        }
 
-        inja::Environment& env = config.getEnvironment();
-        std::string rendered = env.render(tags_index_template, render_data);
+        TagPages& entry = tag_pages.emplace_back();
+        entry.tag = &tag;
+        entry.pages.reserve(tag.pages.size());
+        for (std::size_t position : tag.pages) {
+            entry.pages.push_back(&page_store.view(position));
+        }
+        entry.count = directive_count > 0 ? static_cast<std::size_t>(directive_count) : tag.pages.size();
 
-        std::filesystem::path tags_index_path = tags_output_dir / "index.html";
-        utils::output_file(rendered, tags_index_path);
+        std::size_t total_pages = (entry.pages.size() + entry.count - 1) / entry.count;
+        for (std::size_t idx = 0; idx < total_pages; ++idx) {
+            jobs.emplace_back(tag_pages.size() - 1, idx);
+        }
     }
 
-    for (const auto& tag_entry : tag_collection) {
-        const nlohmann::json& tag_pages = tag_entry["pages"];
-        if (!tag_pages.is_array() || tag_pages.empty()) {
-            continue;
-        }
+    std::atomic<bool> link_failed{ false };
+    utils::parallel_for(pool, jobs.size() + 1, [&](std::size_t job) {
+        if (job == 0) {
+            RenderContext context(config.getData());
+            context.bind("tags", tags);
 
-        int count = directive_count > 0 ? directive_count : static_cast<int>(tag_pages.size());
+            std::string& rendered = utils::render_buffer();
+            context.render_to(config, tags_index_template_name, rendered);
 
-        std::filesystem::path tag_output_dir = tags_output_dir / tag_entry["slug"].get<std::string>();
+            std::filesystem::path tags_index_path = tags_output_dir / "index.html";
+            config.getOutput().write(rendered, tags_index_path);
+            return;
+        }
 
-        Index::render_paginated(
+        const auto& [tag_slot, idx] = jobs[job - 1];
+        const TagPages& entry = tag_pages[tag_slot];
+        const TagIndex::Tag& tag = *entry.tag;
+        Index::render_page(
             config,
-            temp,
-            data,
-            tag_pages,
-            count,
-            tag_output_dir,
-            [&tag_entry, &tag_collection](nlohmann::json& render_data, std::size_t, std::size_t) {
-                render_data["tag"] = tag_entry;
-                render_data["tag"]["pages"] = render_data["pages"];
-                render_data["tags"] = tag_collection;
+            template_name,
+            entry.pages,
+            entry.count,
+            idx,
+            tags_output_dir / tag.slug,
+            aliases,
+            link_failed,
+            [&tag, &tags](RenderContext& context, nlohmann::json& augmented, const nlohmann::json& listing, std::size_t, std::size_t) {
+                // the tag as templates see it; tag.pages is the current window, read
+                // from the listing rather than copied into the tag
+                nlohmann::json& tag_info = augmented["tag"];
+                tag_info["name"] = tag.name;
+                tag_info["slug"] = tag.slug;
+                tag_info["count"] = tag.pages.size();
+                context.bind("tag", tag_info).extend("tag", listing).bind("tags", tags);
             }
         );
-    }
+    }, 1);
 }
@@ -11,7 +11,7 @@
 class Tags : public Directive {
 public:
     Tags() = default;
-    virtual void init(Config& config, const nlohmann::json directive) override;
+    virtual void init(Config& config, ThreadPool& pool, const nlohmann::json directive, bool render) override;
 };
 
 #endif
\ No newline at end of file
@@ -4,11 +4,11 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include "data/config.hpp"
@@ -17,6 +17,13 @@
 #include "utils/logger.hpp"
 #include "builder/builder.hpp"
 #include "utils/debug.hpp"
+#include "utils/thread_pool.hpp"
+#include "server/http_server.hpp"
+#include "server/directory_watcher.hpp"
+
+#ifdef __linux__
+#include <csignal>
+#endif
 
 namespace {
     constexpr unsigned short DEFAULT_SERVER_PORT = 5500;
@@ -76,109 +83,49 @@ namespace {
     struct BuildResult {
         std::filesystem::path site_dir;
         std::filesystem::path output_dir;
+        std::filesystem::path theme_dir;
     };
 
-    class DirectoryWatcher {
-    public:
-        explicit DirectoryWatcher(std::filesystem::path directory)
-            : directory_path(std::move(directory)),
-            snapshot(capture_state()) {
-        }
-
-        bool has_changes() {
-            auto current_state = capture_state();
-            bool changed = false;
-
-            for (const auto& [path, timestamp] : current_state) {
-                auto it = snapshot.find(path);
-                if (it == snapshot.end() || it->second != timestamp) {
-                    changed = true;
-                    break;
-                }
-            }
-
-            if (!changed) {
-                for (const auto& [path, _] : snapshot) {
-                    if (current_state.find(path) == current_state.end()) {
-                        changed = true;
-                        break;
-                    }
-                }
-            }
+    void log_changes(const DirectoryWatcher::Changes& changes) {
+        constexpr std::size_t MAX_LOGGED = 10;
 
-            if (changed) {
-                snapshot = std::move(current_state);
-            }
-
-            return changed;
+        if (changes.everything) {
+            LOG_INFO("Detected changes that could not all be listed; rebuilding everything");
         }
-
-    private:
-        std::filesystem::path directory_path;
-        std::unordered_map<std::string, std::filesystem::file_time_type> snapshot;
-
-        std::unordered_map<std::string, std::filesystem::file_time_type> capture_state() const {
-            std::unordered_map<std::string, std::filesystem::file_time_type> state;
-
-            if (!std::filesystem::exists(directory_path) || !std::filesystem::is_directory(directory_path)) {
-                throw std::runtime_error("Content directory not found or inaccessible: " + directory_path.string());
-            }
-
-            std::error_code ec;
-            std::filesystem::recursive_directory_iterator iterator(
-                directory_path,
-                std::filesystem::directory_options::skip_permission_denied,
-                ec
-            );
-
-            for (auto it = iterator; it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
-                if (ec) {
-                    LOG_WARN("Unable to access " << it->path() << ": " << ec.message());
-                    ec.clear();
-                    continue;
-                }
-
-                if (!it->is_regular_file(ec)) {
-                    ec.clear();
-                    continue;
-                }
-
-                auto write_time = std::filesystem::last_write_time(it->path(), ec);
-                if (ec) {
-                    LOG_WARN("Unable to query last write time for " << it->path() << ": " << ec.message());
-                    ec.clear();
-                    continue;
-                }
-
-                state[it->path().string()] = write_time;
-            }
-
-            return state;
+        else {
+            LOG_INFO("Detected " << changes.paths.size() << " changed path(s)");
         }
-    };
 
-    void update_reload_token(const std::filesystem::path& output_dir) {
-        std::error_code ec;
-        std::filesystem::create_directories(output_dir, ec);
-        if (ec) {
-            LOG_WARN("Failed to create output directory for live reload token: " << output_dir << ". Error: " << ec.message());
-            return;
+        std::size_t logged = 0;
+        for (const auto& path : changes.paths) {
+            if (logged++ == MAX_LOGGED) {
+                LOG_INFO("  ... and " << changes.paths.size() - MAX_LOGGED << " more");
+                break;
+            }
+            LOG_INFO("  " << path);
         }
+    }
 
-        auto token_path = output_dir / "__simple-sg_reload__";
+    void update_reload_token(Output& output) {
+        auto token_path = output.getOutputDirectory() / "__simple-sg_reload__";
         auto now = std::chrono::system_clock::now().time_since_epoch();
         auto token_value = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
 
-        std::filesystem::path writable_path = token_path;
-        if (!utils::output_file(token_value, writable_path)) {
+        if (!output.write(token_value, token_path)) {
             LOG_WARN("Failed to update live reload token file: " << token_path);
         }
     }
 
-    BuildResult build_site(const std::filesystem::path& config_path, bool enable_live_reload) {
-        Config config(config_path);
-        Feeder feeder(config);
-        Builder builder(feeder, enable_live_reload ? LIVE_RELOAD_SNIPPET : "");
+    BuildResult build_site(
+        const std::filesystem::path& config_path,
+        ThreadPool& pool,
+        bool enable_live_reload,
+        MemoryFiles* memory_output = nullptr,
+        BuildSession* session = nullptr
+    ) {
+        Config config(config_path, pool, memory_output);
+        Feeder feeder(config, pool);
+        Builder builder(feeder, pool, enable_live_reload ? LIVE_RELOAD_SNIPPET : "", session);
 
         builder.build();
 
@@ -186,12 +133,65 @@ namespace {
         std::filesystem::path output_dir = site_dir / "output";
 
         if (enable_live_reload) {
-            update_reload_token(output_dir);
+            update_reload_token(config.getOutput());
         }
 
-        return { site_dir, output_dir };
+        return { site_dir, output_dir, config.getThemeDirectory() };
     }
 
+    unsigned int parse_jobs(const std::string& value) {
+        try {
+            std::size_t parsed = 0;
+            int jobs = std::stoi(value, &parsed);
+            if (parsed == value.size() && jobs > 0) {
+                return static_cast<unsigned int>(jobs);
+            }
+        }
+        catch (const std::exception&) {
+        }
+
+        throw std::runtime_error("Invalid --jobs value, expected a positive number: " + value);
+    }
+
+#ifdef __linux__
+    HttpServer* active_server = nullptr;
+
+    void stop_active_server(int) {
+        if (active_server != nullptr) {
+            active_server->stop();
+        }
+    }
+
+    int serve(const std::filesystem::path& output_dir, unsigned short port, const MemoryFiles* memory_output) {
+        // the server outlives the handlers, so a late Ctrl+C never reaches a dead object
+        std::unique_ptr<HttpServer> server;
+        int status = 0;
+        try {
+            server = std::make_unique<HttpServer>(output_dir, port, memory_output);
+            active_server = server.get();
+            std::signal(SIGINT, stop_active_server);
+            std::signal(SIGTERM, stop_active_server);
+
+            if (memory_output) {
+                LOG_INFO("Serving the site from memory on http://localhost:" << port);
+            }
+            else {
+                LOG_INFO("Serving \"" << output_dir << "\" on http://localhost:" << port);
+            }
+            LOG_INFO("Press Ctrl+C to stop the server");
+            server->run();
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("HTTP server failed: " << e.what());
+            status = 1;
+        }
+
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        active_server = nullptr;
+        return status;
+    }
+#else
     std::string detect_python_command() {
         std::vector<std::string> candidates;
 #ifdef _WIN32
@@ -222,74 +222,121 @@ namespace {
         return ss.str();
     }
 
-    int run_server(const std::filesystem::path& config_path) {
+    int serve(const std::filesystem::path& output_dir, unsigned short port, const MemoryFiles* /*memory_output*/) {
+        std::string python_command = detect_python_command();
+        std::string server_command = build_server_command(python_command, output_dir, port);
+
+        LOG_INFO("Serving \"" << output_dir << "\" on http://localhost:" << port);
+        LOG_INFO("Press Ctrl+C to stop the server");
+
+        int server_status = std::system(server_command.c_str());
+        if (server_status != 0) {
+            LOG_WARN("Python HTTP server exited with status code: " << server_status);
+        }
+        return server_status == 0 ? 0 : 1;
+    }
+#endif
+
+    int run_server(const std::filesystem::path& config_path, ThreadPool& pool, bool in_memory) {
         LOG_INFO("Starting simple-sg live server");
 
-        BuildResult initial_build = build_site(config_path, true);
+#ifndef __linux__
+        if (in_memory) {
+            LOG_WARN("--memory needs the built-in server, which is only available on Linux; writing output to disk");
+            in_memory = false;
+        }
+#endif
+        // outlives every build, so rebuilds replace files under the running server
+        MemoryFiles memory_files;
+        MemoryFiles* memory_output = in_memory ? &memory_files : nullptr;
+        BuildSession session;
+
+        BuildResult initial_build = build_site(config_path, pool, true, memory_output, &session);
         LOG_INFO("Initial build complete. Output directory: " << initial_build.output_dir);
 
-        DirectoryWatcher watcher(initial_build.site_dir / "content");
+        DirectoryWatcher watcher(
+            { initial_build.site_dir / "content", initial_build.site_dir / "assets", initial_build.theme_dir },
+            { config_path }
+        );
         std::atomic<bool> keep_running(true);
 
         std::thread watcher_thread([&]() {
             while (keep_running.load()) {
                 try {
-                    if (watcher.has_changes()) {
-                        LOG_INFO("Detected changes in content directory. Rebuilding...");
-                        try {
-                            build_site(config_path, true);
-                            LOG_INFO("Rebuild complete");
-                        }
-                        catch (const std::exception& build_error) {
-                            LOG_ERROR("Rebuild failed: " << build_error.what());
-                        }
+                    DirectoryWatcher::Changes changes = watcher.wait(std::chrono::milliseconds(100));
+                    if (changes.empty()) {
+                        continue;
+                    }
+                    if (!changes.everything && !session.filter(changes.paths)) {
+                        LOG_INFO("Files were saved without changes; nothing to rebuild");
+                        continue;
+                    }
+
+                    log_changes(changes);
+                    session.addChanges(changes.paths, changes.everything);
+                    LOG_INFO("Rebuilding...");
+                    try {
+                        build_site(config_path, pool, true, memory_output, &session);
+                        LOG_INFO("Rebuild complete");
+                    }
+                    catch (const std::exception& build_error) {
+                        LOG_ERROR("Rebuild failed: " << build_error.what());
                     }
                 }
                 catch (const std::exception& e) {
                     LOG_ERROR("Watcher error: " << e.what());
-                }
-
-                for (int i = 0; i < 10 && keep_running.load(); ++i) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    std::this_thread::sleep_for(DirectoryWatcher::SCAN_INTERVAL);
                 }
             }
             });
 
-        std::string python_command = detect_python_command();
-        std::string server_command = build_server_command(python_command, initial_build.output_dir, DEFAULT_SERVER_PORT);
-
-        LOG_INFO("Serving \"" << initial_build.output_dir << "\" on http://localhost:" << DEFAULT_SERVER_PORT);
-        LOG_INFO("Press Ctrl+C to stop the server");
-
-        int server_status = std::system(server_command.c_str());
-        if (server_status != 0) {
-            LOG_WARN("Python HTTP server exited with status code: " << server_status);
-        }
+        int server_status = serve(initial_build.output_dir, DEFAULT_SERVER_PORT, memory_output);
 
         keep_running.store(false);
         if (watcher_thread.joinable()) {
             watcher_thread.join();
         }
 
-        return server_status == 0 ? 0 : 1;
+        return server_status;
     }
 }
 
 int main(int argc, char* argv[]) {
     bool server_mode = false;
+    bool in_memory = false;
     std::filesystem::path config_path = "config.json";
+    unsigned int jobs = 0;
 
     try {
-        if (argc > 1) {
-            std::string first_argument(argv[1]);
-            if (first_argument == "server") {
+        std::vector<std::string> arguments;
+        for (int i = 1; i < argc; ++i) {
+            std::string argument(argv[i]);
+            if (argument == "--jobs" || argument == "-j") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                jobs = parse_jobs(argv[++i]);
+            }
+            else if (argument.rfind("--jobs=", 0) == 0) {
+                jobs = parse_jobs(argument.substr(7));
+            }
+            else if (argument == "--memory") {
+                in_memory = true;
+            }
+            else {
+                arguments.push_back(argument);
+            }
+        }
+
+        if (!arguments.empty()) {
+            if (arguments[0] == "server") {
                 server_mode = true;
-                if (argc > 2) {
-                    config_path = argv[2];
+                if (arguments.size() > 1) {
+                    config_path = arguments[1];
                 }
             }
             else {
-                config_path = first_argument;
+                config_path = arguments[0];
             }
         }
 
@@ -299,11 +346,17 @@ int main(int argc, char* argv[]) {
             throw std::runtime_error(ss.str());
         }
 
+        if (in_memory && !server_mode) {
+            throw std::runtime_error("--memory is only supported in server mode");
+        }
+
+        ThreadPool pool(jobs);
+
         if (server_mode) {
-            return run_server(config_path);
+            return run_server(config_path, pool, in_memory);
         }
 
-        BuildResult build = build_site(config_path, false);
+        BuildResult build = build_site(config_path, pool, false);
         LOG_INFO("Building succeeded. Output directory: " << build.output_dir);
 
 #ifdef DEBUG
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "directory_watcher.hpp"
+#include "../utils/utils.hpp"
+
+namespace {
+    bool is_within(const std::filesystem::path& path, const std::filesystem::path& base) {
+        auto [base_end, path_end] = std::mismatch(base.begin(), base.end(), path.begin(), path.end());
+        return base_end == base.end();
+    }
+
+    std::vector<std::filesystem::path> absolute_paths(const std::vector<std::filesystem::path>& paths) {
+        std::vector<std::filesystem::path> result;
+        for (const auto& path : paths) {
+            result.push_back(std::filesystem::absolute(path).lexically_normal());
+        }
+        return result;
+    }
+}
+
+DirectoryWatcher::DirectoryWatcher(const std::vector<std::filesystem::path>& directories, const std::vector<std::filesystem::path>& files) :
+    directories(absolute_paths(directories)),
+    files(absolute_paths(files))
+{
+    if (!start_inotify()) {
+        LOG_WARN("inotify is unavailable, watching for changes by scanning every " << SCAN_INTERVAL.count() << " ms");
+        start_scanning();
+    }
+}
+
+void DirectoryWatcher::start_scanning() {
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        ::close(inotify_fd);
+        inotify_fd = -1;
+    }
+#endif
+    watches.clear();
+    snapshot = capture_state();
+    last_scan = std::chrono::steady_clock::now();
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        ::close(inotify_fd);
+    }
+#endif
+}
+
+DirectoryWatcher::Changes DirectoryWatcher::wait(std::chrono::milliseconds timeout) {
+    return usesInotify() ? wait_inotify(timeout) : wait_scan(timeout);
+}
+
+bool DirectoryWatcher::is_root(const std::filesystem::path& path) const {
+    return std::find(directories.begin(), directories.end(), path) != directories.end();
+}
+
+bool DirectoryWatcher::start_inotify() {
+#ifdef __linux__
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        return false;
+    }
+
+    try {
+        // the parent watches notice roots and files being created, replaced or removed
+        for (const auto& dir : directories) {
+            watch_entry(dir.parent_path(), dir.filename().string());
+            watch_tree(dir, nullptr);
+        }
+        for (const auto& file : files) {
+            watch_entry(file.parent_path(), file.filename().string());
+        }
+    }
+    catch (const std::exception& e) {
+        LOG_WARN(e.what());
+        ::close(inotify_fd);
+        inotify_fd = -1;
+        watches.clear();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+int DirectoryWatcher::add_watch(const std::filesystem::path& dir) {
+#ifdef __linux__
+    constexpr std::uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO
+        | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+    int wd = ::inotify_add_watch(inotify_fd, dir.c_str(), mask);
+    if (wd < 0 && errno != ENOENT && errno != ENOTDIR) {
+        std::stringstream ss;
+        ss << "Failed to watch " << dir << ": " << std::strerror(errno);
+        throw std::runtime_error(ss.str());
+    }
+    return wd;
+#else
+    (void)dir;
+    return -1;
+#endif
+}
+
+void DirectoryWatcher::watch_entry(const std::filesystem::path& dir, const std::string& name) {
+    int wd = add_watch(dir);
+    if (wd < 0) {
+        return;
+    }
+    Watch& watch = watches[wd];
+    watch.dir = dir;
+    watch.names.insert(name);
+}
+
+void DirectoryWatcher::watch_tree(const std::filesystem::path& dir, Changes* created) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec)) {
+        return;
+    }
+
+    int wd = add_watch(dir);
+    if (wd < 0) {
+        return;
+    }
+    Watch& watch = watches[wd];
+    watch.dir = dir;
+    watch.recursive = true;
+
+    // anything already inside was created before the watch existed
+    for (const auto& entry : std::filesystem::directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec)) {
+        if (std::filesystem::is_directory(entry.symlink_status(ec))) {
+            watch_tree(entry.path(), created);
+        }
+        else if (created && entry.is_regular_file(ec)) {
+            created->paths.insert(entry.path());
+        }
+    }
+}
+
+bool DirectoryWatcher::read_events(Changes& changes) {
+#ifdef __linux__
+    alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+    bool any = false;
+
+    while (true) {
+        ssize_t length = ::read(inotify_fd, buffer.data(), buffer.size());
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            break;
+        }
+        any = true;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                changes.everything = true;
+                continue;
+            }
+
+            auto it = watches.find(event->wd);
+            if (it == watches.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches.erase(it);
+                continue;
+            }
+            Watch& watch = it->second;
+
+            if (event->mask & IN_MOVE_SELF) {
+                // the kernel keeps following the directory to wherever it went
+                if (watch.recursive) {
+                    changes.paths.insert(watch.dir);
+                    ::inotify_rm_watch(inotify_fd, event->wd);
+                }
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+
+            std::string name(event->name);
+            std::filesystem::path path = watch.dir / name;
+            bool arrived = event->mask & (IN_CREATE | IN_MOVED_TO);
+
+            if (!watch.recursive) {
+                if (watch.names.count(name) == 0) {
+                    continue;
+                }
+                changes.paths.insert(path);
+                if ((event->mask & IN_ISDIR) && arrived && is_root(path)) {
+                    watch_tree(path, &changes);
+                }
+                continue;
+            }
+
+            if (event->mask & IN_ISDIR) {
+                if (arrived) {
+                    watch_tree(path, &changes);
+                }
+                else {
+                    changes.paths.insert(path);
+                    // a directory moved out of the tree keeps its watches unless dropped
+                    for (const auto& [wd, sub] : watches) {
+                        if (is_within(sub.dir, path)) {
+                            ::inotify_rm_watch(inotify_fd, wd);
+                        }
+                    }
+                }
+                continue;
+            }
+
+            changes.paths.insert(path);
+        }
+    }
+    return any;
+#else
+    (void)changes;
+    return false;
+#endif
+}
+
+DirectoryWatcher::Changes DirectoryWatcher::wait_inotify(std::chrono::milliseconds timeout) {
+    Changes changes;
+#ifdef __linux__
+    pollfd descriptor{ inotify_fd, POLLIN, 0 };
+    if (::poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0) {
+        return changes;
+    }
+
+    try {
+        read_events(changes);
+
+        // let the rest of a save (or a checkout) arrive, but not forever
+        auto deadline = std::chrono::steady_clock::now() + SCAN_INTERVAL;
+        while (std::chrono::steady_clock::now() < deadline
+            && ::poll(&descriptor, 1, static_cast<int>(SETTLE_TIME.count())) > 0) {
+            read_events(changes);
+        }
+    }
+    catch (const std::exception& e) {
+        // a new directory could not be watched (e.g. out of watches), so whatever
+        // happens in it would go unseen; scanning sees everything, if more slowly
+        LOG_WARN(e.what() << "; watching for changes by scanning every " << SCAN_INTERVAL.count() << " ms from now on");
+        start_scanning();
+        changes.everything = true;
+    }
+#else
+    (void)timeout;
+#endif
+    return changes;
+}
+
+DirectoryWatcher::Changes DirectoryWatcher::wait_scan(std::chrono::milliseconds timeout) {
+    Changes changes;
+
+    auto due = last_scan + SCAN_INTERVAL;
+    auto now = std::chrono::steady_clock::now();
+    if (now < due) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, timeout));
+        if (std::chrono::steady_clock::now() < due) {
+            return changes;
+        }
+    }
+
+    Snapshot current = capture_state();
+    last_scan = std::chrono::steady_clock::now();
+
+    for (const auto& [path, timestamp] : current) {
+        auto it = snapshot.find(path);
+        if (it == snapshot.end() || it->second != timestamp) {
+            changes.paths.insert(path);
+        }
+    }
+    for (const auto& [path, _] : snapshot) {
+        if (current.find(path) == current.end()) {
+            changes.paths.insert(path);
+        }
+    }
+
+    snapshot = std::move(current);
+    return changes;
+}
+
+DirectoryWatcher::Snapshot DirectoryWatcher::capture_state() const {
+    Snapshot state;
+
+    auto record = [&state](const std::filesystem::path& path) {
+        std::error_code ec;
+        auto write_time = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            LOG_WARN("Unable to query last write time for " << path << ": " << ec.message());
+            return;
+        }
+        state[path.string()] = write_time;
+    };
+
+    for (const auto& dir : directories) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(dir, ec)) {
+            continue;
+        }
+
+        std::filesystem::recursive_directory_iterator iterator(
+            dir,
+            std::filesystem::directory_options::skip_permission_denied,
+            ec
+        );
+
+        for (auto it = iterator; it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) {
+                LOG_WARN("Unable to access " << it->path() << ": " << ec.message());
+                ec.clear();
+                continue;
+            }
+
+            if (!it->is_regular_file(ec)) {
+                ec.clear();
+                continue;
+            }
+            record(it->path());
+        }
+    }
+
+    for (const auto& file : files) {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(file, ec)) {
+            record(file);
+        }
+    }
+
+    return state;
+}
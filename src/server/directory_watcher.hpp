@@ -0,0 +1,73 @@
+#ifndef DIRECTORY_WATCHER_HPP_
+#define DIRECTORY_WATCHER_HPP_
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports which of the watched files changed. Directories are watched
+// recursively and single files by name, so editors that save by renaming a
+// temporary file are still seen. Uses inotify where available and falls back
+// to comparing periodic stat scans.
+class DirectoryWatcher {
+public:
+    struct Changes {
+        std::set<std::filesystem::path> paths;
+        // events were lost (queue overflow, or inotify gave up); anything may have changed
+        bool everything = false;
+
+        bool empty() const { return paths.empty() && !everything; }
+    };
+
+    // directories and files to watch; either may not exist yet
+    DirectoryWatcher(const std::vector<std::filesystem::path>& directories, const std::vector<std::filesystem::path>& files);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // blocks for at most timeout; an empty result means nothing changed
+    Changes wait(std::chrono::milliseconds timeout);
+    bool usesInotify() const { return inotify_fd >= 0; }
+
+    static constexpr std::chrono::milliseconds SCAN_INTERVAL{ 1000 };
+    // quiet period that folds the several events of one save into one change set
+    static constexpr std::chrono::milliseconds SETTLE_TIME{ 50 };
+
+private:
+    using Snapshot = std::unordered_map<std::string, std::filesystem::file_time_type>;
+
+    struct Watch {
+        std::filesystem::path dir;
+        bool recursive = false;
+        std::set<std::string> names;    // entries of interest when not recursive
+    };
+
+    std::vector<std::filesystem::path> directories;
+    std::vector<std::filesystem::path> files;
+
+    int inotify_fd = -1;
+    std::unordered_map<int, Watch> watches;
+
+    Snapshot snapshot;
+    std::chrono::steady_clock::time_point last_scan;
+
+    bool start_inotify();
+    // drops inotify for the rest of the session and compares stat scans from now on
+    void start_scanning();
+    void watch_tree(const std::filesystem::path& dir, Changes* created);
+    void watch_entry(const std::filesystem::path& dir, const std::string& name);
+    int add_watch(const std::filesystem::path& dir);
+    bool read_events(Changes& changes);
+    bool is_root(const std::filesystem::path& path) const;
+
+    Changes wait_inotify(std::chrono::milliseconds timeout);
+    Changes wait_scan(std::chrono::milliseconds timeout);
+    Snapshot capture_state() const;
+};
+
+#endif
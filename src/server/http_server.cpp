@@ -0,0 +1,706 @@
+#ifdef __linux__
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <csignal>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "http_server.hpp"
+#include "../utils/utils.hpp"
+
+namespace {
+    constexpr std::size_t MAX_HEADER_SIZE = 16 * 1024;
+    constexpr std::size_t READ_CHUNK = 8 * 1024;
+    // reading stops once this much input waits to be answered
+    constexpr std::size_t MAX_INPUT_SIZE = MAX_HEADER_SIZE + READ_CHUNK;
+    constexpr int MAX_EVENTS = 64;
+    constexpr auto KEEP_ALIVE_TIMEOUT = std::chrono::seconds(15);
+    constexpr auto ACCEPT_BACKOFF = std::chrono::milliseconds(250);
+
+    std::string system_error(const std::string& what) {
+        std::stringstream ss;
+        ss << what << ": " << std::strerror(errno);
+        return ss.str();
+    }
+
+    const char* status_text(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 301: return "Moved Permanently";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 431: return "Request Header Fields Too Large";
+        default:  return "Internal Server Error";
+        }
+    }
+
+    std::string_view mime_type(const std::filesystem::path& path) {
+        static const std::unordered_map<std::string, std::string_view> types = {
+            { ".html",  "text/html; charset=utf-8" },
+            { ".htm",   "text/html; charset=utf-8" },
+            { ".css",   "text/css; charset=utf-8" },
+            { ".js",    "text/javascript; charset=utf-8" },
+            { ".mjs",   "text/javascript; charset=utf-8" },
+            { ".json",  "application/json" },
+            { ".map",   "application/json" },
+            { ".xml",   "application/xml" },
+            { ".txt",   "text/plain; charset=utf-8" },
+            { ".md",    "text/markdown; charset=utf-8" },
+            { ".svg",   "image/svg+xml" },
+            { ".png",   "image/png" },
+            { ".jpg",   "image/jpeg" },
+            { ".jpeg",  "image/jpeg" },
+            { ".gif",   "image/gif" },
+            { ".webp",  "image/webp" },
+            { ".avif",  "image/avif" },
+            { ".ico",   "image/x-icon" },
+            { ".woff",  "font/woff" },
+            { ".woff2", "font/woff2" },
+            { ".ttf",   "font/ttf" },
+            { ".otf",   "font/otf" },
+            { ".pdf",   "application/pdf" },
+            { ".mp3",   "audio/mpeg" },
+            { ".mp4",   "video/mp4" },
+            { ".webm",  "video/webm" },
+            { ".wasm",  "application/wasm" },
+        };
+
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        auto it = types.find(extension);
+        return it != types.end() ? it->second : "application/octet-stream";
+    }
+
+    bool iequals(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](char x, char y) { return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y)); });
+    }
+
+    bool contains_token(std::string_view list, std::string_view token) {
+        while (!list.empty()) {
+            std::size_t comma = list.find(',');
+            std::string_view item = utils::trim(list.substr(0, comma));
+            item = utils::trim(item.substr(0, item.find(';')));
+            if (iequals(item, token)) {
+                return true;
+            }
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            list.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    // percent-decodes the path of a request target; nullopt for malformed input
+    std::optional<std::string> decode_path(std::string_view target) {
+        target = target.substr(0, target.find_first_of("?#"));
+
+        std::string decoded;
+        decoded.reserve(target.size());
+        for (std::size_t i = 0; i < target.size(); ++i) {
+            if (target[i] != '%') {
+                decoded += target[i];
+                continue;
+            }
+            if (i + 2 >= target.size() || !std::isxdigit(static_cast<unsigned char>(target[i + 1]))
+                || !std::isxdigit(static_cast<unsigned char>(target[i + 2]))) {
+                return std::nullopt;
+            }
+            decoded += static_cast<char>(std::stoi(std::string(target.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        }
+
+        if (decoded.empty() || decoded[0] != '/' || decoded.find('\0') != std::string::npos) {
+            return std::nullopt;
+        }
+        return decoded;
+    }
+
+    // root-relative path for a decoded request path; nullopt if it escapes the root
+    std::optional<std::filesystem::path> resolve(std::string_view request_path) {
+        std::filesystem::path relative;
+        while (!request_path.empty()) {
+            std::size_t slash = request_path.find('/');
+            std::string_view segment = request_path.substr(0, slash);
+            if (segment == "..") {
+                return std::nullopt;
+            }
+            if (!segment.empty() && segment != ".") {
+                relative /= std::string(segment);
+            }
+            if (slash == std::string_view::npos) {
+                break;
+            }
+            request_path.remove_prefix(slash + 1);
+        }
+        return relative;
+    }
+}
+
+HttpServer::HttpServer(const std::filesystem::path& root, unsigned short port, const MemoryFiles* memory) :
+    root(root), memory(memory)
+{
+    // a client hanging up mid-sendfile must not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(system_error("Failed to create server socket"));
+    }
+
+    int enable = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || ::listen(listen_fd, SOMAXCONN) < 0) {
+        std::string message = system_error("Failed to listen on port " + std::to_string(port));
+        ::close(listen_fd);
+        throw std::runtime_error(message);
+    }
+
+    epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        std::string message = system_error("Failed to set up the server event loop");
+        ::close(listen_fd);
+        if (epoll_fd >= 0) ::close(epoll_fd);
+        if (wake_fd >= 0) ::close(wake_fd);
+        throw std::runtime_error(message);
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.fd = wake_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+HttpServer::~HttpServer() {
+    while (!connections.empty()) {
+        close_connection(connections.begin()->first);
+    }
+    ::close(wake_fd);
+    ::close(epoll_fd);
+    ::close(listen_fd);
+}
+
+void HttpServer::stop() {
+    running.store(false);
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void HttpServer::run() {
+    running.store(true);
+    std::array<epoll_event, MAX_EVENTS> events;
+    auto last_sweep = std::chrono::steady_clock::now();
+
+    while (running.load()) {
+        int timeout = accept_paused ? static_cast<int>(ACCEPT_BACKOFF.count()) : 1000;
+        int count = ::epoll_wait(epoll_fd, events.data(), MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(system_error("Server event loop failed"));
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                accept_connections();
+                continue;
+            }
+            if (fd == wake_fd) {
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(fd);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && connection.writing) {
+                if (!flush(connection) || !process_requests(connection)) {
+                    continue;
+                }
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                on_readable(connection);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (accept_paused && now >= accept_resume) {
+            resume_accepting();
+        }
+        if (now - last_sweep >= std::chrono::seconds(1)) {
+            close_idle_connections();
+            last_sweep = now;
+        }
+    }
+}
+
+void HttpServer::accept_connections() {
+    while (true) {
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // the pending connection stays queued and the listen socket readable,
+                // so it is left out of the loop for a while instead of spinning on it
+                LOG_WARN(system_error("Failed to accept connection") + "; retrying shortly");
+                pause_accepting();
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN(system_error("Failed to accept connection"));
+            }
+            return;
+        }
+
+        int enable = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->last_active = std::chrono::steady_clock::now();
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        connections.emplace(fd, std::move(connection));
+    }
+}
+
+void HttpServer::pause_accepting() {
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, listen_fd, nullptr);
+    accept_paused = true;
+    accept_resume = std::chrono::steady_clock::now() + ACCEPT_BACKOFF;
+}
+
+void HttpServer::resume_accepting() {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    accept_paused = false;
+    accept_connections();
+}
+
+void HttpServer::close_connection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return;
+    }
+    if (it->second->file_fd >= 0) {
+        ::close(it->second->file_fd);
+    }
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(it);
+}
+
+void HttpServer::watch(Connection& connection, bool writable) {
+    if (connection.writing == writable) {
+        return;
+    }
+    connection.writing = writable;
+
+    epoll_event event{};
+    event.events = writable ? EPOLLOUT : (EPOLLIN | EPOLLRDHUP);
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void HttpServer::close_idle_connections() {
+    auto deadline = std::chrono::steady_clock::now() - KEEP_ALIVE_TIMEOUT;
+    std::vector<int> idle;
+    for (const auto& [fd, connection] : connections) {
+        if (connection->last_active < deadline) {
+            idle.push_back(fd);
+        }
+    }
+    for (int fd : idle) {
+        close_connection(fd);
+    }
+}
+
+bool HttpServer::on_readable(Connection& connection) {
+    char buffer[READ_CHUNK];
+    // anything beyond the cap stays in the socket until the input has been answered
+    while (connection.input.size() < MAX_INPUT_SIZE) {
+        ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<std::size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received < 0) {
+            close_connection(connection.fd);
+            return false;
+        }
+        // a half-closed client still gets answers to what it sent
+        connection.read_closed = true;
+        break;
+    }
+
+    connection.last_active = std::chrono::steady_clock::now();
+    return process_requests(connection);
+}
+
+bool HttpServer::process_requests(Connection& connection) {
+    // requests are answered strictly in order; a pipelined request waits in
+    // the input buffer until the previous response has been sent
+    while (!connection.writing) {
+        std::size_t head_end = connection.input.find("\r\n\r\n");
+        if (head_end == std::string::npos) {
+            if (connection.input.size() > MAX_HEADER_SIZE) {
+                connection.keep_alive = false;
+                respond_status(connection, 431);
+                connection.input.clear();
+                return flush(connection);
+            }
+            if (connection.read_closed) {
+                // everything that will ever arrive has been answered
+                close_connection(connection.fd);
+                return false;
+            }
+            return true;
+        }
+
+        respond(connection, std::string_view(connection.input.data(), head_end));
+        connection.input.erase(0, head_end + 4);
+
+        if (!flush(connection)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpServer::flush(Connection& connection) {
+    while (connection.output_sent < connection.output.size()) {
+        int flags = MSG_NOSIGNAL | (connection.file_remaining > 0 || connection.body ? MSG_MORE : 0);
+        ssize_t sent = ::send(connection.fd, connection.output.data() + connection.output_sent,
+            connection.output.size() - connection.output_sent, flags);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(connection, true);
+                return true;
+            }
+            close_connection(connection.fd);
+            return false;
+        }
+        connection.output_sent += static_cast<std::size_t>(sent);
+    }
+
+    while (connection.body && connection.body_sent < connection.body->content.size()) {
+        ssize_t sent = ::send(connection.fd, connection.body->content.data() + connection.body_sent,
+            connection.body->content.size() - connection.body_sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(connection, true);
+                return true;
+            }
+            close_connection(connection.fd);
+            return false;
+        }
+        connection.body_sent += static_cast<std::size_t>(sent);
+    }
+
+    while (connection.file_remaining > 0) {
+        ssize_t sent = ::sendfile(connection.fd, connection.file_fd, &connection.file_offset, connection.file_remaining);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(connection, true);
+                return true;
+            }
+            close_connection(connection.fd);
+            return false;
+        }
+        if (sent == 0) {
+            // file shrank underneath us; the promised length can no longer be met
+            close_connection(connection.fd);
+            return false;
+        }
+        connection.file_remaining -= static_cast<std::size_t>(sent);
+    }
+
+    if (connection.file_fd >= 0) {
+        ::close(connection.file_fd);
+        connection.file_fd = -1;
+    }
+    connection.body.reset();
+    connection.output.clear();
+    connection.output_sent = 0;
+    connection.last_active = std::chrono::steady_clock::now();
+
+    if (!connection.keep_alive) {
+        close_connection(connection.fd);
+        return false;
+    }
+    watch(connection, false);
+    return true;
+}
+
+void HttpServer::respond_status(Connection& connection, int status, std::string_view extra_headers) {
+    std::string body = std::to_string(status) + " " + status_text(status) + "\n";
+
+    std::stringstream ss;
+    ss << "HTTP/1.1 " << status << " " << status_text(status) << "\r\n"
+       << "Server: simple-sg\r\n"
+       << extra_headers;
+    if (status == 304) {
+        ss << "Connection: " << (connection.keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+    }
+    else {
+        ss << "Content-Type: text/plain; charset=utf-8\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: " << (connection.keep_alive ? "keep-alive" : "close") << "\r\n\r\n"
+           << body;
+    }
+    connection.output = ss.str();
+    connection.output_sent = 0;
+}
+
+void HttpServer::respond(Connection& connection, std::string_view head) {
+    std::size_t line_end = head.find("\r\n");
+    std::string_view request_line = head.substr(0, line_end);
+    std::string_view headers = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+
+    std::size_t first_space = request_line.find(' ');
+    std::size_t second_space = request_line.find(' ', first_space + 1);
+    if (first_space == std::string_view::npos || second_space == std::string_view::npos) {
+        connection.keep_alive = false;
+        respond_status(connection, 400);
+        return;
+    }
+    std::string_view method = request_line.substr(0, first_space);
+    std::string_view target = request_line.substr(first_space + 1, second_space - first_space - 1);
+    std::string_view version = request_line.substr(second_space + 1);
+
+    connection.keep_alive = version == "HTTP/1.1";
+    std::string_view if_none_match;
+    bool accepts_gzip = false;
+
+    while (!headers.empty()) {
+        std::size_t end = headers.find("\r\n");
+        std::string_view line = headers.substr(0, end);
+        headers = end == std::string_view::npos ? std::string_view() : headers.substr(end + 2);
+
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = utils::trim(line.substr(colon + 1));
+
+        if (iequals(name, "Connection")) {
+            if (contains_token(value, "close")) {
+                connection.keep_alive = false;
+            }
+            else if (contains_token(value, "keep-alive")) {
+                connection.keep_alive = true;
+            }
+        }
+        else if (iequals(name, "If-None-Match")) {
+            if_none_match = value;
+        }
+        else if (iequals(name, "Accept-Encoding")) {
+            accepts_gzip = contains_token(value, "gzip");
+        }
+    }
+
+    bool head_only = method == "HEAD";
+    if (method != "GET" && !head_only) {
+        // the request body was not read, so the stream cannot be reused
+        connection.keep_alive = false;
+        respond_status(connection, 405, "Allow: GET, HEAD\r\n");
+        return;
+    }
+
+    std::optional<std::string> request_path = decode_path(target);
+    if (!request_path.has_value()) {
+        respond_status(connection, 400);
+        return;
+    }
+    std::optional<std::filesystem::path> relative = resolve(request_path.value());
+    if (!relative.has_value()) {
+        respond_status(connection, 403);
+        return;
+    }
+
+    std::string key = relative->generic_string();
+    std::error_code ec;
+    bool is_directory = memory
+        ? memory->isDirectory(key) && !memory->contains(key)
+        : std::filesystem::is_directory(root / key, ec);
+    if (is_directory) {
+        if (request_path->back() != '/') {
+            std::string location(target.substr(0, target.find_first_of("?#")));
+            respond_status(connection, 301, "Location: " + location + "/\r\n");
+            return;
+        }
+        key = key.empty() ? "index.html" : key + "/index.html";
+    }
+    std::string_view content_type = mime_type(key);
+
+    // a precompressed sibling is served as-is to clients that accept gzip
+    bool gzipped = false;
+    bool has_gz = false;
+    std::size_t size = 0;
+    std::stringstream etag;
+    std::shared_ptr<const MemoryFiles::File> body;
+    int file_fd = -1;
+
+    if (memory) {
+        if (accepts_gzip && (body = memory->find(key + ".gz"))) {
+            gzipped = true;
+        }
+        else if (!(body = memory->find(key))) {
+            respond_status(connection, 404);
+            return;
+        }
+        has_gz = gzipped || memory->contains(key + ".gz");
+        size = body->content.size();
+        etag << "\"m" << std::hex << body->version;
+    }
+    else {
+        // the size and validators come from the descriptor that is sent, not a path
+        // that may have been replaced in between
+        auto open_regular = [](const std::filesystem::path& path, struct stat& info) {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0 && (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))) {
+                ::close(fd);
+                errno = ENOENT;
+                return -1;
+            }
+            return fd;
+        };
+
+        struct stat info {};
+        file_fd = open_regular(root / key, info);
+        if (file_fd < 0) {
+            respond_status(connection, errno == EACCES ? 403 : 404);
+            return;
+        }
+
+        std::filesystem::path gz_path = root / key;
+        gz_path += ".gz";
+        if (accepts_gzip) {
+            struct stat gz_info {};
+            int gz_fd = open_regular(gz_path, gz_info);
+            if (gz_fd >= 0) {
+                ::close(file_fd);
+                file_fd = gz_fd;
+                info = gz_info;
+                gzipped = true;
+            }
+        }
+        struct stat gz_info {};
+        has_gz = gzipped || (::stat(gz_path.c_str(), &gz_info) == 0 && S_ISREG(gz_info.st_mode));
+        size = static_cast<std::size_t>(info.st_size);
+        etag << '"' << std::hex << info.st_size << '-' << info.st_mtim.tv_sec << '.' << info.st_mtim.tv_nsec;
+    }
+    etag << (gzipped ? "-gz" : "") << '"';
+    std::string etag_value = etag.str();
+
+    std::stringstream validators;
+    validators << "ETag: " << etag_value << "\r\n"
+               << "Cache-Control: no-cache\r\n";
+    // caches must keep the two encodings apart whichever one this client gets
+    if (has_gz) {
+        validators << "Vary: Accept-Encoding\r\n";
+    }
+
+    if (!if_none_match.empty() && (if_none_match == "*" || if_none_match.find(etag_value) != std::string_view::npos)) {
+        if (file_fd >= 0) {
+            ::close(file_fd);
+        }
+        respond_status(connection, 304, validators.str());
+        return;
+    }
+    if (head_only && file_fd >= 0) {
+        ::close(file_fd);
+        file_fd = -1;
+    }
+
+    std::stringstream ss;
+    ss << "HTTP/1.1 200 OK\r\n"
+       << "Server: simple-sg\r\n"
+       << "Content-Type: " << content_type << "\r\n"
+       << "Content-Length: " << size << "\r\n"
+       << validators.str();
+    if (gzipped) {
+        ss << "Content-Encoding: gzip\r\n";
+    }
+    ss << "Connection: " << (connection.keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+
+    connection.output = ss.str();
+    connection.output_sent = 0;
+    if (memory) {
+        connection.body = head_only ? nullptr : std::move(body);
+        connection.body_sent = 0;
+    }
+    else {
+        connection.file_fd = file_fd;
+        connection.file_offset = 0;
+        connection.file_remaining = head_only ? 0 : size;
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef HTTP_SERVER_HPP_
+#define HTTP_SERVER_HPP_
+
+#ifdef __linux__
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+#include "../utils/memory_files.hpp"
+
+// Static file server for the live-reload preview. One epoll loop serves every
+// connection: keep-alive, file bodies through sendfile(2), ETag/304 handling
+// and precompressed .gz siblings for clients that accept gzip. Given a
+// MemoryFiles store, files are served from it and root is not read.
+class HttpServer {
+private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        // pending response head (and small bodies), then a body from memory or a file
+        std::string output;
+        std::size_t output_sent = 0;
+        std::shared_ptr<const MemoryFiles::File> body;
+        std::size_t body_sent = 0;
+        int file_fd = -1;
+        off_t file_offset = 0;
+        std::size_t file_remaining = 0;
+        bool keep_alive = true;
+        bool writing = false;
+        bool read_closed = false;       // the client has sent all it will send
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    std::filesystem::path root;
+    const MemoryFiles* memory;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::atomic<bool> running{ false };
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    // set while the listen socket is out of the loop after running out of descriptors
+    std::chrono::steady_clock::time_point accept_resume;
+    bool accept_paused = false;
+
+    void accept_connections();
+    void pause_accepting();
+    void resume_accepting();
+    void close_connection(int fd);
+    void watch(Connection& connection, bool writable);
+
+    // false once the connection has been closed
+    bool on_readable(Connection& connection);
+    bool process_requests(Connection& connection);
+    bool flush(Connection& connection);
+
+    void respond(Connection& connection, std::string_view head);
+    void respond_status(Connection& connection, int status, std::string_view extra_headers = {});
+    void close_idle_connections();
+
+public:
+    HttpServer(const std::filesystem::path& root, unsigned short port, const MemoryFiles* memory = nullptr);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // serves until stop() is called
+    void run();
+    // safe to call from another thread or from a signal handler
+    void stop();
+};
+
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+#include <cstdio>
+
+#include "date.hpp"
+
+namespace {
+    // reads between min_count and max_count digits at pos and moves past them
+    bool read_digits(std::string_view text, std::size_t& pos, std::size_t min_count, std::size_t max_count, int& value) {
+        std::size_t start = pos;
+        value = 0;
+        while (pos < text.size() && pos - start < max_count && text[pos] >= '0' && text[pos] <= '9') {
+            value = value * 10 + (text[pos] - '0');
+            ++pos;
+        }
+        return pos - start >= min_count;
+    }
+
+    bool read_digits(std::string_view text, std::size_t& pos, std::size_t count, int& value) {
+        return read_digits(text, pos, count, count, value);
+    }
+
+    bool read_char(std::string_view text, std::size_t& pos, char expected) {
+        if (pos < text.size() && text[pos] == expected) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    // +-HH[:MM] or +-HHMM at pos; Z is handled by the caller
+    bool read_offset(std::string_view text, std::size_t& pos, int& minutes) {
+        if (pos >= text.size() || (text[pos] != '+' && text[pos] != '-')) {
+            return false;
+        }
+        int sign = text[pos++] == '-' ? -1 : 1;
+
+        int hours = 0;
+        int mins = 0;
+        if (!read_digits(text, pos, 2, hours)) {
+            return false;
+        }
+        if (pos < text.size()) {
+            read_char(text, pos, ':');
+            if (!read_digits(text, pos, 2, mins)) {
+                return false;
+            }
+        }
+
+        if (hours > 23 || mins > 59) {
+            return false;
+        }
+        minutes = sign * (hours * 60 + mins);
+        return true;
+    }
+
+    bool is_leap(int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    int days_in_month(int year, int month) {
+        static constexpr int DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        return month == 2 && is_leap(year) ? 29 : DAYS[month - 1];
+    }
+
+    // days since 1970-01-01 in the proleptic Gregorian calendar
+    long long days_from_civil(int year, int month, int day) {
+        year -= month <= 2;
+        const long long era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+        const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return era * 146097 + static_cast<long long>(day_of_era) - 719468;
+    }
+
+    void civil_from_days(long long days, int& year, int& month, int& day) {
+        days += 719468;
+        const long long era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+        const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        const unsigned month_index = (5 * day_of_year + 2) / 153;
+        day = static_cast<int>(day_of_year - (153 * month_index + 2) / 5 + 1);
+        month = static_cast<int>(month_index < 10 ? month_index + 3 : month_index - 9);
+        year = static_cast<int>(year_of_era + era * 400 + (month <= 2));
+    }
+
+    bool parse_iso(std::string_view text, utils::DateTime& date) {
+        std::size_t pos = 0;
+        if (!read_digits(text, pos, 4, date.year) || !read_char(text, pos, '-')
+            || !read_digits(text, pos, 2, date.month) || !read_char(text, pos, '-')
+            || !read_digits(text, pos, 2, date.day)) {
+            return false;
+        }
+        if (pos == text.size()) {
+            return true;
+        }
+
+        if (text[pos] != 'T' && text[pos] != 't' && text[pos] != ' ') {
+            return false;
+        }
+        ++pos;
+        if (!read_digits(text, pos, 2, date.hour) || !read_char(text, pos, ':')
+            || !read_digits(text, pos, 2, date.minute)) {
+            return false;
+        }
+        if (read_char(text, pos, ':')) {
+            if (!read_digits(text, pos, 2, date.second)) {
+                return false;
+            }
+            // fractions of a second do not make it into a timestamp
+            if (read_char(text, pos, '.') || read_char(text, pos, ',')) {
+                std::size_t fraction = pos;
+                while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                    ++pos;
+                }
+                if (pos == fraction) {
+                    return false;
+                }
+            }
+        }
+        if (pos == text.size()) {
+            return true;
+        }
+
+        int offset = 0;
+        if (text[pos] == 'Z' || text[pos] == 'z') {
+            ++pos;
+        }
+        else if (!read_offset(text, pos, offset)) {
+            return false;
+        }
+        date.offset_minutes = offset;
+        return pos == text.size();
+    }
+
+    // as std::get_time reads %d-%m-%Y %H:%M, days, months, hours and minutes may have one digit
+    bool parse_legacy(std::string_view text, utils::DateTime& date) {
+        std::size_t pos = 0;
+        if (!read_digits(text, pos, 1, 2, date.day) || !read_char(text, pos, '-')
+            || !read_digits(text, pos, 1, 2, date.month) || !read_char(text, pos, '-')
+            || !read_digits(text, pos, 4, date.year)) {
+            return false;
+        }
+        if (pos == text.size()) {
+            return true;
+        }
+
+        return read_char(text, pos, ' ')
+            && read_digits(text, pos, 1, 2, date.hour) && read_char(text, pos, ':')
+            && read_digits(text, pos, 1, 2, date.minute)
+            && pos == text.size();
+    }
+}
+
+std::optional<utils::DateTime> utils::parse_date(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+
+    DateTime date;
+    // the year comes first in ISO dates, so the fifth character tells the two apart
+    bool parsed = text.size() > 4 && text[4] == '-' ? parse_iso(text, date) : parse_legacy(text, date);
+    if (!parsed) {
+        return std::nullopt;
+    }
+
+    // a leap second is accepted, and lands on the next minute
+    if (date.month < 1 || date.month > 12 || date.day < 1 || date.day > days_in_month(date.year, date.month)
+        || date.hour > 23 || date.minute > 59 || date.second > 60) {
+        return std::nullopt;
+    }
+    return date;
+}
+
+std::optional<int> utils::parse_utc_offset(std::string_view text) {
+    if (text == "UTC" || text == "utc" || text == "Z" || text == "z") {
+        return 0;
+    }
+
+    std::size_t pos = 0;
+    int minutes = 0;
+    if (!read_offset(text, pos, minutes) || pos != text.size()) {
+        return std::nullopt;
+    }
+    return minutes;
+}
+
+std::time_t utils::to_timestamp(const DateTime& date, std::optional<int> offset_minutes) {
+    if (date.offset_minutes.has_value()) {
+        offset_minutes = date.offset_minutes;
+    }
+
+    if (!offset_minutes.has_value()) {
+        std::tm tm = {};
+        tm.tm_year = date.year - 1900;
+        tm.tm_mon = date.month - 1;
+        tm.tm_mday = date.day;
+        tm.tm_hour = date.hour;
+        tm.tm_min = date.minute;
+        tm.tm_sec = date.second;
+        tm.tm_isdst = -1;
+        return std::mktime(&tm);
+    }
+
+    long long seconds = days_from_civil(date.year, date.month, date.day) * 86400LL
+        + date.hour * 3600LL + date.minute * 60LL + date.second;
+    return static_cast<std::time_t>(seconds - offset_minutes.value() * 60LL);
+}
+
+std::string utils::format_date(std::time_t time, std::optional<int> offset_minutes) {
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+
+    if (offset_minutes.has_value()) {
+        long long seconds = static_cast<long long>(time) + offset_minutes.value() * 60LL;
+        long long days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+        long long of_day = seconds - days * 86400;
+        civil_from_days(days, year, month, day);
+        hour = static_cast<int>(of_day / 3600);
+        minute = static_cast<int>(of_day % 3600 / 60);
+    }
+    else {
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
+        year = tm.tm_year + 1900;
+        month = tm.tm_mon + 1;
+        day = tm.tm_mday;
+        hour = tm.tm_hour;
+        minute = tm.tm_min;
+    }
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02d-%02d-%04d %02d:%02d", day, month, year, hour, minute);
+    return buffer;
+}
@@ -0,0 +1,34 @@
+#ifndef DATE_HPP_
+#define DATE_HPP_
+
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace utils {
+    // a date and time as written in frontmatter, before any timezone is applied
+    struct DateTime {
+        int year = 1970;
+        int month = 1;
+        int day = 1;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+        std::optional<int> offset_minutes;  // east of UTC, when the text carries one
+    };
+
+    // ISO 8601 (YYYY-MM-DD, optionally followed by T or a space, HH:MM[:SS[.fraction]]
+    // and Z or +-HH[:MM]) or DD-MM-YYYY[ HH:MM]; nullopt for anything else. Never allocates.
+    std::optional<DateTime> parse_date(std::string_view text);
+    // "UTC", "Z" or +-HH[:MM], as minutes east of UTC; "local" and anything else is nullopt
+    std::optional<int>      parse_utc_offset(std::string_view text);
+
+    // the offset written in the date wins over offset_minutes; without either the
+    // date is local time, which goes through mktime and libc's timezone lock
+    std::time_t             to_timestamp(const DateTime& date, std::optional<int> offset_minutes);
+    // time as DD-MM-YYYY HH:MM at offset_minutes east of UTC, or in local time without one
+    std::string             format_date(std::time_t time, std::optional<int> offset_minutes);
+}
+
+#endif
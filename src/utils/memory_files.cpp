@@ -0,0 +1,67 @@
+#include <mutex>
+
+#include "memory_files.hpp"
+
+void MemoryFiles::put(const std::string& relative_path, std::string content) {
+    auto file = std::make_shared<const File>(File{ std::move(content), next_version.fetch_add(1) });
+
+    std::unique_lock<std::shared_mutex> lock(files_mutex);
+    files[relative_path] = std::move(file);
+}
+
+bool MemoryFiles::link(const std::string& target, const std::string& relative_path) {
+    std::unique_lock<std::shared_mutex> lock(files_mutex);
+    auto it = files.find(target);
+    if (it == files.end()) {
+        return false;
+    }
+    files[relative_path] = it->second;
+    return true;
+}
+
+void MemoryFiles::erase(const std::string& relative_path) {
+    std::unique_lock<std::shared_mutex> lock(files_mutex);
+    files.erase(relative_path);
+}
+
+void MemoryFiles::clear() {
+    std::unique_lock<std::shared_mutex> lock(files_mutex);
+    files.clear();
+}
+
+std::shared_ptr<const MemoryFiles::File> MemoryFiles::find(const std::string& relative_path) const {
+    std::shared_lock<std::shared_mutex> lock(files_mutex);
+    auto it = files.find(relative_path);
+    return it != files.end() ? it->second : nullptr;
+}
+
+bool MemoryFiles::contains(const std::string& relative_path) const {
+    std::shared_lock<std::shared_mutex> lock(files_mutex);
+    return files.find(relative_path) != files.end();
+}
+
+bool MemoryFiles::isDirectory(const std::string& relative_path) const {
+    std::string prefix = relative_path;
+    if (!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+    }
+
+    std::shared_lock<std::shared_mutex> lock(files_mutex);
+    auto it = files.lower_bound(prefix);
+    return it != files.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool MemoryFiles::empty() const {
+    std::shared_lock<std::shared_mutex> lock(files_mutex);
+    return files.empty();
+}
+
+std::set<std::string> MemoryFiles::paths() const {
+    std::set<std::string> result;
+
+    std::shared_lock<std::shared_mutex> lock(files_mutex);
+    for (const auto& [path, file] : files) {
+        result.insert(result.end(), path);
+    }
+    return result;
+}
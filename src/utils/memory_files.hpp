@@ -0,0 +1,43 @@
+#ifndef MEMORY_FILES_HPP_
+#define MEMORY_FILES_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+
+// Output files kept in memory instead of on disk, shared between the builder
+// and the dev server. Files are replaced whole and handed out as immutable
+// snapshots, so a reader never sees a half-written file or a half-empty site.
+// Paths are relative to the output directory, in generic form.
+class MemoryFiles {
+public:
+    struct File {
+        std::string content;
+        std::uint64_t version;  // unique per write, usable as a validator
+    };
+
+private:
+    mutable std::shared_mutex files_mutex;
+    std::map<std::string, std::shared_ptr<const File>> files;
+    std::atomic<std::uint64_t> next_version{ 1 };
+
+public:
+    void                            put(const std::string& relative_path, std::string content);
+    // relative_path serves the same file as target; false if there is no target
+    bool                            link(const std::string& target, const std::string& relative_path);
+    void                            erase(const std::string& relative_path);
+    void                            clear();
+
+    std::shared_ptr<const File>     find(const std::string& relative_path) const;
+    bool                            contains(const std::string& relative_path) const;
+    // true if some file lives below relative_path
+    bool                            isDirectory(const std::string& relative_path) const;
+    bool                            empty() const;
+    std::set<std::string>           paths() const;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "output.hpp"
+
+Output::Output(const std::filesystem::path& output_dir, MemoryFiles* memory) :
+    output_dir(output_dir), memory(memory)
+{
+}
+
+std::string Output::relative(const std::filesystem::path& file_path) const {
+    return file_path.lexically_relative(output_dir).generic_string();
+}
+
+bool Output::write(std::string_view str, const std::filesystem::path& file_path) {
+    if (memory) {
+        memory->put(relative(file_path), std::string(str));
+    }
+    else {
+        // a link left by a build with pagination aliases would be written through
+        std::error_code ec;
+        std::filesystem::file_status status = std::filesystem::symlink_status(file_path, ec);
+        if (std::filesystem::is_symlink(status)
+            || (std::filesystem::is_regular_file(status) && std::filesystem::hard_link_count(file_path, ec) > 1)) {
+            std::filesystem::remove(file_path, ec);
+        }
+
+        std::filesystem::path writable_path = file_path;
+        if (!utils::output_file(str, writable_path)) {
+            return false;
+        }
+    }
+
+    record(file_path);
+    return true;
+}
+
+void Output::copy(const std::filesystem::path& source, const std::filesystem::path& file_path) {
+    if (memory) {
+        std::string content;
+        if (!utils::read_file(source, content)) {
+            throw std::runtime_error("Failed to read file: " + source.string());
+        }
+        memory->put(relative(file_path), std::move(content));
+    }
+    else {
+        std::filesystem::copy_file(source, file_path, std::filesystem::copy_options::overwrite_existing);
+    }
+
+    record(file_path);
+}
+
+bool Output::link(const std::filesystem::path& target, const std::filesystem::path& file_path, bool symbolic) {
+    if (memory) {
+        if (!memory->link(relative(target), relative(file_path))) {
+            return false;
+        }
+    }
+    else {
+        std::error_code ec;
+        std::filesystem::create_directories(file_path.parent_path(), ec);
+        // whatever the previous build left there, possibly a copy or a link of the other kind
+        std::filesystem::remove(file_path, ec);
+        if (symbolic) {
+            std::filesystem::create_symlink(target.lexically_relative(file_path.parent_path()), file_path, ec);
+        }
+        else {
+            std::filesystem::create_hard_link(target, file_path, ec);
+        }
+        if (ec) {
+            return false;
+        }
+    }
+
+    record(file_path);
+    return true;
+}
+
+void Output::record(const std::filesystem::path& file_path) {
+    std::string relative_path = relative(file_path);
+
+    std::lock_guard<std::mutex> lock(written_mutex);
+    written.insert(std::move(relative_path));
+}
+
+bool Output::exists(const std::filesystem::path& file_path) const {
+    if (memory) {
+        return memory->contains(relative(file_path));
+    }
+    return std::filesystem::exists(file_path);
+}
+
+void Output::remove(const std::filesystem::path& file_path) {
+    if (memory) {
+        memory->erase(relative(file_path));
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(file_path, ec);
+    if (ec) {
+        std::stringstream ss;
+        ss << "Failed to remove " << file_path << ": " << ec.message();
+        throw std::runtime_error(ss.str());
+    }
+
+    // stop at the output directory itself
+    for (std::filesystem::path dir = file_path.parent_path(); dir != output_dir && !dir.empty(); dir = dir.parent_path()) {
+        if (!std::filesystem::is_directory(dir, ec) || !std::filesystem::is_empty(dir, ec)) {
+            break;
+        }
+        std::filesystem::remove(dir, ec);
+    }
+}
+
+void Output::clear() {
+    if (memory) {
+        memory->clear();
+        return;
+    }
+    utils::clear_directory(output_dir);
+}
+
+void Output::create_directories(const std::filesystem::path& dir) {
+    if (!memory) {
+        std::filesystem::create_directories(dir);
+    }
+}
+
+std::set<std::string> Output::getWritten() const {
+    std::lock_guard<std::mutex> lock(written_mutex);
+    return written;
+}
+
+std::set<std::string> Output::getStored() const {
+    return memory ? memory->paths() : std::set<std::string>();
+}
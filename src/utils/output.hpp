@@ -0,0 +1,50 @@
+#ifndef OUTPUT_HPP_
+#define OUTPUT_HPP_
+
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include "utils.hpp"
+#include "memory_files.hpp"
+
+// Single place every build step writes its files through, so a build knows
+// exactly which outputs it produced. Safe to use from several threads.
+// With a MemoryFiles store the output directory is never touched; paths still
+// name files under it and map to the same relative keys.
+class Output {
+private:
+    std::filesystem::path output_dir;
+    MemoryFiles* memory;
+    mutable std::mutex written_mutex;
+    std::set<std::string> written;
+
+public:
+    explicit Output(const std::filesystem::path& output_dir, MemoryFiles* memory = nullptr);
+
+    bool write(std::string_view str, const std::filesystem::path& file_path);
+    void copy(const std::filesystem::path& source, const std::filesystem::path& file_path);
+    // makes file_path a hard or symbolic link to target, an output written earlier;
+    // false if the filesystem refused, in which case nothing is recorded
+    bool link(const std::filesystem::path& target, const std::filesystem::path& file_path, bool symbolic);
+    // records a file this build owns without writing it (unchanged pages)
+    void record(const std::filesystem::path& file_path);
+
+    bool exists(const std::filesystem::path& file_path) const;
+    // removes a file and any directories that were left empty by it
+    void remove(const std::filesystem::path& file_path);
+    void clear();
+    void create_directories(const std::filesystem::path& dir);
+    bool inMemory() const { return memory != nullptr; }
+
+    // file_path relative to the output directory, in generic form
+    std::string                     relative(const std::filesystem::path& file_path) const;
+
+    const std::filesystem::path&    getOutputDirectory() const { return output_dir; }
+    std::set<std::string>           getWritten() const;
+    // every file currently in the memory store; empty when writing to disk
+    std::set<std::string>           getStored() const;
+};
+
+#endif
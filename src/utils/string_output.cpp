@@ -0,0 +1,25 @@
+#include "string_output.hpp"
+
+StringOutput::StringOutput(std::string& target) :
+    std::ostream(nullptr),
+    buffer(target)
+{
+    rdbuf(&buffer);
+}
+
+StringOutput::Buffer::int_type StringOutput::Buffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        target.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize StringOutput::Buffer::xsputn(const char* s, std::streamsize count) {
+    target.append(s, static_cast<std::size_t>(count));
+    return count;
+}
+
+std::string& utils::render_buffer() {
+    thread_local std::string buffer;
+    return buffer;
+}
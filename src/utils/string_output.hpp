@@ -0,0 +1,38 @@
+#ifndef STRING_OUTPUT_HPP_
+#define STRING_OUTPUT_HPP_
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// std::ostream that appends to a caller-owned string. Rendering into one skips
+// the copy out of a std::stringstream, and the string keeps its capacity when
+// it is reused for the next render.
+class StringOutput : public std::ostream {
+private:
+    class Buffer : public std::streambuf {
+    private:
+        std::string& target;
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+    public:
+        explicit Buffer(std::string& target) : target(target) { }
+    };
+
+    Buffer buffer;
+
+public:
+    explicit StringOutput(std::string& target);
+};
+
+namespace utils {
+    // buffer for rendered pages, one per thread and reused for every page it renders;
+    // the contents are only valid until the thread renders again, so it must not be
+    // held across anything that may run another render task, such as TaskGroup::wait
+    std::string& render_buffer();
+}
+
+#endif
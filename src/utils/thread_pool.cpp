@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+
+#include "thread_pool.hpp"
+
+namespace {
+    // queue owned by the current thread, if it is a pool worker
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local std::size_t current_queue = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < num_threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 0; i < num_threads; ++i) {
+        threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void ThreadPool::push(Task task) {
+    std::size_t index = current_pool == this
+        ? current_queue
+        : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::tryRun(std::size_t home) {
+    Task task;
+
+    for (std::size_t offset = 0; offset < queues.size() && !task; ++offset) {
+        Queue& queue = *queues[(home + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        // newest from our own queue (still warm in cache), oldest when stealing
+        if (offset == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        --queued;
+    }
+    task();
+    return true;
+}
+
+bool ThreadPool::runPending() {
+    return tryRun(current_pool == this ? current_queue : 0);
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        if (tryRun(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::~TaskGroup() {
+    // tasks refer to the group, so it cannot go away before they finish
+    try {
+        wait();
+    }
+    catch (...) {
+    }
+}
+
+void TaskGroup::submit(std::function<void()> task) {
+    remaining.fetch_add(1);
+    pool.push([this, task = std::move(task)] {
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+
+        // under the lock, so wait() cannot return and destroy the group while it is still in use here
+        std::lock_guard<std::mutex> lock(done_mutex);
+        if (remaining.fetch_sub(1) == 1) {
+            done.notify_all();
+        }
+    });
+}
+
+void TaskGroup::wait() {
+    while (remaining.load() > 0) {
+        if (pool.runPending()) {
+            continue;
+        }
+
+        // nothing to help with; sleep until done, checking back for new tasks now and then
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait_for(lock, std::chrono::milliseconds(1), [this] { return remaining.load() == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(done_mutex);
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+void utils::parallel_for(ThreadPool& pool, std::size_t count, const std::function<void(std::size_t)>& fn, std::size_t batch_size) {
+    if (count == 0) {
+        return;
+    }
+
+    if (batch_size == 0) {
+        batch_size = std::max<std::size_t>(1, count / (static_cast<std::size_t>(pool.size()) * 4));
+    }
+
+    TaskGroup group(pool);
+    for (std::size_t start = 0; start < count; start += batch_size) {
+        std::size_t end = std::min(start + batch_size, count);
+        group.submit([&fn, start, end] {
+            for (std::size_t i = start; i < end; ++i) {
+                fn(i);
+            }
+        });
+    }
+    group.wait();
+}
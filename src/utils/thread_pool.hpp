@@ -0,0 +1,84 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long-lived pool of workers shared by every build phase. Each worker owns a
+// task deque: it takes its newest task first and steals the oldest tasks of
+// other workers when it runs dry. Threads that wait on a TaskGroup run queued
+// tasks in the meantime, so tasks may submit and wait on nested groups.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 picks std::thread::hardware_concurrency(), and never fewer than one worker
+    explicit ThreadPool(unsigned int num_threads = 0);
+    ~ThreadPool();
+
+    unsigned int size() const { return static_cast<unsigned int>(threads.size()); }
+
+    // runs one queued task on the calling thread; false if there was none
+    bool runPending();
+
+private:
+    friend class TaskGroup;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::size_t queued = 0;     // guarded by wake_mutex
+    bool stopping = false;      // guarded by wake_mutex
+    std::atomic<std::size_t> next_queue{ 0 };
+
+    void push(Task task);
+    bool tryRun(std::size_t home);
+    void workerLoop(std::size_t index);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+// A batch of tasks that can be waited on together. The first exception thrown
+// by a task is rethrown from wait(); the remaining tasks still run.
+class TaskGroup {
+private:
+    ThreadPool& pool;
+    std::atomic<std::size_t> remaining{ 0 };
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool(pool) { }
+    ~TaskGroup();
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+};
+
+namespace utils {
+    // calls fn(i) for every i in [0, count), batch_size indices per task, and waits for all of them;
+    // a batch_size of 0 picks one that gives each worker a few batches
+    void parallel_for(ThreadPool& pool, std::size_t count, const std::function<void(std::size_t)>& fn, std::size_t batch_size = 0);
+}
+
+#endif
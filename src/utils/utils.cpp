@@ -4,17 +4,17 @@ namespace utils {
     std::mutex logMutex;
 }
 
-std::pair<std::optional<std::string>, std::optional<std::string>> utils::extract(const std::string& str, int extraction_type) {
+std::pair<std::optional<std::string_view>, std::optional<std::string_view>> utils::extract(std::string_view str, int extraction_type) {
     constexpr std::string_view delimiter = "---";
 
     size_t start = str.find(delimiter);
-    std::optional<std::string> frontmatter;
-    std::optional<std::string> markdown;
+    std::optional<std::string_view> frontmatter;
+    std::optional<std::string_view> markdown;
 
-    if (start != std::string::npos) {
+    if (start != std::string_view::npos) {
         start += delimiter.length();
         size_t end = str.find(delimiter, start);
-        if (end != std::string::npos) {
+        if (end != std::string_view::npos) {
             if (extraction_type & FRONTMATTER) {
                 frontmatter = trim(str.substr(start, end - start));
             }
@@ -37,19 +37,14 @@ std::pair<std::optional<std::string>, std::optional<std::string>> utils::extract
 }
 
 
-std::string utils::trim(const std::string& str) {
+std::string_view utils::trim(std::string_view str) {
     size_t first = str.find_first_not_of(" \t\n\r");
-    if (first == std::string::npos) return "";
+    if (first == std::string_view::npos) return {};
     size_t last = str.find_last_not_of(" \t\n\r");
     return str.substr(first, (last - first + 1));
 }
 
-void utils::handle_md(const MD_CHAR* md, MD_SIZE size, void* data) {
-    std::stringstream* html_stream = static_cast<std::stringstream*>(data);
-    *html_stream << std::string(static_cast<const char*>(md), size);
-}
-
-bool utils::output_file(const std::string& str, std::filesystem::path& file_path) {
+bool utils::output_file(std::string_view str, std::filesystem::path& file_path) {
     std::filesystem::path directory = file_path.parent_path();
 
     if (!directory.empty() && !std::filesystem::exists(directory)) {
@@ -65,7 +60,7 @@ bool utils::output_file(const std::string& str, std::filesystem::path& file_path
     if (!output_file_stream.is_open()) {
         return false;
     }
-    output_file_stream << str;
+    output_file_stream.write(str.data(), static_cast<std::streamsize>(str.size()));
     if (!output_file_stream.good()) {
         output_file_stream.close();
         return false;
@@ -106,3 +101,47 @@ void utils::clear_directory(const std::filesystem::path& dir) {
         }
     }
 }
+
+
+bool utils::read_file(const std::filesystem::path& file_path, std::string& out) {
+    std::ifstream input_file_stream(file_path, std::ios::in | std::ios::binary);
+    if (!input_file_stream.is_open()) {
+        return false;
+    }
+
+    // size the buffer once and fill it with a single read; out keeps its capacity
+    // across calls, so a reused buffer stops allocating once it fits the largest file
+    input_file_stream.seekg(0, std::ios::end);
+    std::streamoff size = input_file_stream.tellg();
+    if (size < 0) {
+        return false;
+    }
+    input_file_stream.seekg(0, std::ios::beg);
+
+    out.resize(static_cast<std::size_t>(size));
+    input_file_stream.read(out.data(), size);
+    out.resize(static_cast<std::size_t>(input_file_stream.gcount()));
+    return !input_file_stream.bad();
+}
+
+std::uint64_t utils::hash(std::string_view data, std::uint64_t seed) {
+    constexpr std::uint64_t prime = 1099511628211ULL;
+
+    std::uint64_t value = seed;
+    for (unsigned char c : data) {
+        value ^= c;
+        value *= prime;
+    }
+    return value;
+}
+
+std::string utils::to_hex(std::uint64_t value) {
+    static constexpr const char* digits = "0123456789abcdef";
+
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        hex[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return hex;
+}
@@ -4,7 +4,8 @@
 #include <iostream>
 #include <sstream>
 #include <optional>
-#include <md4c-html.h>
+#include <cstdint>
+#include <string_view>
 #include <filesystem>
 #include <mutex>
 #include <fstream>
@@ -24,7 +25,8 @@ namespace utils {
         MARKDOWN = 1 << 1
     };
 
-    std::pair<std::optional<std::string>, std::optional<std::string>> extract(const std::string& str, int extraction_type);
+    // the returned views point into str, which must outlive them
+    std::pair<std::optional<std::string_view>, std::optional<std::string_view>> extract(std::string_view str, int extraction_type);
     std::filesystem::path   getOutputPath(
         const std::filesystem::path& content_dir,
         const std::filesystem::path& output_dir,
@@ -36,12 +38,17 @@ namespace utils {
         const std::filesystem::path& target
     );
     std::streamsize         getFileLen(std::ifstream& file);
-    std::string             trim(const std::string& str);
+    std::string_view        trim(std::string_view str);
     std::string             fetch_stream();
-    bool                    output_file(const std::string& str, std::filesystem::path& file_path);
-    void                    handle_md(const MD_CHAR* stuff, MD_SIZE size, void* data);
-    bool                    output_file(const std::string& str, std::filesystem::path& file_path);
+    bool                    output_file(std::string_view str, std::filesystem::path& file_path);
+    bool                    output_file(std::string_view str, std::filesystem::path& file_path);
     void                    clear_directory(const std::filesystem::path& dir);
+    bool                    read_file(const std::filesystem::path& file_path, std::string& out);
+
+    // FNV-1a, stable across runs and platforms; chain calls by passing the previous result as seed
+    constexpr std::uint64_t HASH_SEED = 14695981039346656037ULL;
+    std::uint64_t           hash(std::string_view data, std::uint64_t seed = HASH_SEED);
+    std::string             to_hex(std::uint64_t value);
 }
 
 #endif
@@ -0,0 +1,38 @@
+# Builds the site in SITE from a scratch copy in WORK_DIR with SIMPLE_SG and
+# compares its output with SITE/expected.
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(GLOB SITE_FILES LIST_DIRECTORIES true "${SITE}/*")
+foreach(SITE_FILE ${SITE_FILES})
+  get_filename_component(SITE_FILE_NAME "${SITE_FILE}" NAME)
+  if(NOT SITE_FILE_NAME STREQUAL "expected")
+    file(COPY "${SITE_FILE}" DESTINATION "${WORK_DIR}")
+  endif()
+endforeach()
+
+# the build waits for a key press before exiting when built with DEBUG
+file(WRITE "${WORK_DIR}/.keypress" "\n")
+execute_process(
+  COMMAND "${SIMPLE_SG}" config.json
+  WORKING_DIRECTORY "${WORK_DIR}"
+  INPUT_FILE "${WORK_DIR}/.keypress"
+  RESULT_VARIABLE BUILD_RESULT
+  OUTPUT_VARIABLE BUILD_LOG
+  ERROR_VARIABLE BUILD_LOG
+)
+if(NOT BUILD_RESULT EQUAL 0)
+  message(FATAL_ERROR "Building ${SITE} failed:\n${BUILD_LOG}")
+endif()
+
+file(GLOB_RECURSE EXPECTED_FILES RELATIVE "${SITE}/expected" "${SITE}/expected/*")
+foreach(EXPECTED_FILE ${EXPECTED_FILES})
+  set(ACTUAL_PATH "${WORK_DIR}/output/${EXPECTED_FILE}")
+  if(NOT EXISTS "${ACTUAL_PATH}")
+    message(FATAL_ERROR "${EXPECTED_FILE} was not written:\n${BUILD_LOG}")
+  endif()
+  file(READ "${SITE}/expected/${EXPECTED_FILE}" EXPECTED)
+  file(READ "${ACTUAL_PATH}" ACTUAL)
+  if(NOT EXPECTED STREQUAL ACTUAL)
+    message(FATAL_ERROR "${EXPECTED_FILE} differs\nexpected:\n${EXPECTED}\nactual:\n${ACTUAL}")
+  endif()
+endforeach()